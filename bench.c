@@ -0,0 +1,400 @@
+/*
+ * Copyright (c) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+
+#include <gtk/gtk.h>
+#include "fake-module.h"
+#include "interactive.h"
+
+/* Drives interactive pages that are never shown through the paths that
+ * typing at the prompt takes, and prints how long they took as JSON.
+ * It fails if pages outlive being destroyed. Run it with 'make bench'. */
+
+#define STARTUP_RUNS   5
+#define COMPLETE_RUNS  50
+#define EVAL_RUNS      200
+#define PRINT_LINES    10000
+#define EXTRA_PAGES    4
+
+static gboolean first_result = TRUE;
+static guint pages_finalized;
+
+static gdouble
+elapsed_ms (gint64 start)
+{
+  return (g_get_monotonic_time () - start) / 1000.0;
+}
+
+static gint
+compare_doubles (gconstpointer a,
+                 gconstpointer b)
+{
+  gdouble da = *(const gdouble *)a;
+  gdouble db = *(const gdouble *)b;
+
+  return (da > db) - (da < db);
+}
+
+static gdouble
+percentile (GArray  *sorted,
+            gdouble  p)
+{
+  guint i = (guint)(p * (sorted->len - 1) + 0.5);
+
+  return g_array_index (sorted, gdouble, i);
+}
+
+static void
+begin_result (const gchar *name,
+              const gchar *unit)
+{
+  g_print ("%s\n    { \"name\": \"%s\", \"unit\": \"%s\"",
+           first_result ? "" : ",", name, unit);
+  first_result = FALSE;
+}
+
+/* Reports the first of the samples on its own, since that is the cold
+ * run, and the distribution of the rest */
+static void
+report_samples (const gchar *name,
+                GArray      *samples)
+{
+  gdouble first = g_array_index (samples, gdouble, 0);
+
+  g_array_remove_index (samples, 0);
+  g_array_sort (samples, compare_doubles);
+
+  begin_result (name, "ms");
+  g_print (", \"runs\": %u, \"first\": %.3f, \"min\": %.3f, \"median\": %.3f, \"p95\": %.3f, \"max\": %.3f }",
+           samples->len, first,
+           g_array_index (samples, gdouble, 0),
+           percentile (samples, 0.5),
+           percentile (samples, 0.95),
+           g_array_index (samples, gdouble, samples->len - 1));
+}
+
+static void
+drain_main_loop (void)
+{
+  while (g_main_context_pending (NULL))
+    g_main_context_iteration (NULL, FALSE);
+}
+
+static void
+count_finalized (gpointer data)
+{
+  pages_finalized++;
+}
+
+/* The data goes when the page is finalized, not when it is disposed */
+static GtkInspectorInteractive *
+new_page (void)
+{
+  GObject *page = (GObject *)g_object_ref_sink (g_object_new (GTK_TYPE_INSPECTOR_INTERACTIVE, NULL));
+
+  g_object_set_data_full (page, "bench-page", page, count_finalized);
+
+  return GTK_INSPECTOR_INTERACTIVE (page);
+}
+
+/* As the inspector does when its window goes */
+static void
+destroy_page (gpointer page)
+{
+  gtk_widget_destroy (GTK_WIDGET (page));
+  g_object_unref (page);
+}
+
+/* Construction to the first evaluation having returned, which is when
+ * the prompt is usable. Returns whether every page was finalized once
+ * destroyed, which takes the GC the page schedules. */
+static gboolean
+bench_startup (void)
+{
+  GArray *samples = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  GString *output = g_string_new (NULL);
+  guint finalized_before = pages_finalized;
+  guint i;
+
+  for (i = 0; i < STARTUP_RUNS; i++)
+    {
+      GtkInspectorInteractive *page;
+      gint64 start = g_get_monotonic_time ();
+      gdouble ms;
+
+      page = new_page ();
+      gtk_inspector_interactive_eval (page, "0", output);
+      ms = elapsed_ms (start);
+      g_array_append_val (samples, ms);
+
+      g_string_truncate (output, 0);
+      drain_main_loop ();
+      destroy_page (page);
+    }
+  drain_main_loop ();
+
+  report_samples ("startup", samples);
+
+  g_array_unref (samples);
+  g_string_free (output, TRUE);
+
+  if (pages_finalized - finalized_before < STARTUP_RUNS)
+    {
+      g_printerr ("%u of %d pages were not finalized after being destroyed\n",
+                  STARTUP_RUNS - (pages_finalized - finalized_before), STARTUP_RUNS);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Tab with text in the entry, the first run doing any imports */
+static void
+bench_complete (GtkInspectorInteractive *page,
+                const gchar             *name,
+                const gchar             *text)
+{
+  GtkEntry *entry;
+  GArray *samples = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  guint i;
+
+  entry = GTK_ENTRY (gtk_widget_get_template_child (GTK_WIDGET (page),
+                                                    GTK_TYPE_INSPECTOR_INTERACTIVE,
+                                                    "entry"));
+
+  for (i = 0; i < COMPLETE_RUNS + 1; i++)
+    {
+      gint64 start;
+      gdouble ms;
+
+      gtk_entry_set_text (entry, text);
+      gtk_editable_set_position (GTK_EDITABLE (entry), -1);
+
+      start = g_get_monotonic_time ();
+      g_signal_emit_by_name (page, "complete");
+      ms = elapsed_ms (start);
+      g_array_append_val (samples, ms);
+    }
+
+  gtk_entry_set_text (entry, "");
+  report_samples (name, samples);
+
+  g_array_unref (samples);
+}
+
+static void
+bench_eval (GtkInspectorInteractive *page)
+{
+  GArray *samples = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  GString *output = g_string_new (NULL);
+  guint i;
+
+  for (i = 0; i < EVAL_RUNS + 1; i++)
+    {
+      gint64 start = g_get_monotonic_time ();
+      gdouble ms;
+
+      gtk_inspector_interactive_eval (page, "1 + 1", output);
+      ms = elapsed_ms (start);
+      g_array_append_val (samples, ms);
+      g_string_truncate (output, 0);
+    }
+
+  report_samples ("eval", samples);
+
+  g_array_unref (samples);
+  g_string_free (output, TRUE);
+}
+
+/* Evaluations and completions used to prefix what they evaluate with
+ * this header of imports, and now evaluate against a scope object
+ * built once. The two runs evaluate the same expression with and
+ * without it, so their difference is what each evaluation and each
+ * Tab used to spend on the header. */
+#define OLD_HEADER \
+  "const GLib = imports.gi.GLib;" \
+  "const GObject = imports.gi.GObject;" \
+  "const Gio = imports.gi.Gio;" \
+  "const Pango = imports.gi.Pango;" \
+  "const Cairo = imports.cairo;" \
+  "const Gtk = imports.gi.Gtk;" \
+  "const r = imports.inspector.repl.getResult;" \
+  "const retained = imports.inspector.repl.retained;"
+
+static void
+bench_header_run (GtkInspectorInteractive *page,
+                  const gchar             *name,
+                  const gchar             *header)
+{
+  GArray *samples = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  gchar *script;
+  guint i;
+
+  script = g_strdup_printf ("(function () { return eval(%s'1 + 1'); })()", header);
+
+  for (i = 0; i < EVAL_RUNS + 1; i++)
+    {
+      gint64 start = g_get_monotonic_time ();
+      gdouble ms;
+
+      gtk_inspector_interactive_eval (page, script, NULL);
+      ms = elapsed_ms (start);
+      g_array_append_val (samples, ms);
+    }
+
+  report_samples (name, samples);
+
+  g_array_unref (samples);
+  g_free (script);
+}
+
+static void
+bench_header (GtkInspectorInteractive *page)
+{
+  bench_header_run (page, "eval with the old header", "'" OLD_HEADER "' + ");
+  bench_header_run (page, "eval without the old header", "");
+}
+
+/* Lines printed into the text view per second, until they are all in
+ * the buffer */
+static void
+bench_print (GtkInspectorInteractive *page)
+{
+  gchar *script;
+  gint64 start;
+  gdouble ms;
+
+  script = g_strdup_printf ("for (let i = 0; i < %d; i++) print('line ' + i)", PRINT_LINES);
+
+  drain_main_loop ();
+  start = g_get_monotonic_time ();
+  gtk_inspector_interactive_eval (page, script, NULL);
+  drain_main_loop ();
+  ms = elapsed_ms (start);
+
+  begin_result ("print", "lines/s");
+  g_print (", \"lines\": %d, \"ms\": %.3f, \"value\": %.0f }", PRINT_LINES, ms, PRINT_LINES / (ms / 1000.0));
+
+  g_free (script);
+}
+
+/* The JS heap of all pages, which share one runtime when they are
+ * shared-runtime pages */
+static guint64
+total_heap (GPtrArray *pages)
+{
+  guint64 total = 0;
+  guint i;
+
+  for (i = 0; i < pages->len; i++)
+    {
+      guint64 size;
+      gboolean shared;
+
+      g_object_get (pages->pdata[i], "heap-size", &size, "shared-runtime", &shared, NULL);
+      if (shared)
+        return size;
+      total += size;
+    }
+
+  return total;
+}
+
+static guint64
+collected_heap (GPtrArray *pages)
+{
+  guint i;
+
+  for (i = 0; i < pages->len; i++)
+    gtk_inspector_interactive_eval (pages->pdata[i], "__gc()", NULL);
+
+  return total_heap (pages);
+}
+
+/* How much the JS heap grows with each page opened after the first */
+static void
+bench_pages (void)
+{
+  GPtrArray *pages = g_ptr_array_new_with_free_func (destroy_page);
+  guint64 one = 0, all;
+  guint i;
+
+  for (i = 0; i < EXTRA_PAGES + 1; i++)
+    {
+      g_ptr_array_add (pages, new_page ());
+      gtk_inspector_interactive_eval (pages->pdata[i], "0", NULL);
+      drain_main_loop ();
+
+      if (i == 0)
+        one = collected_heap (pages);
+    }
+
+  all = collected_heap (pages);
+
+  begin_result ("heap per extra page", "bytes");
+  g_print (", \"pages\": %d, \"first\": %" G_GUINT64_FORMAT ", \"value\": %.0f }",
+           EXTRA_PAGES + 1, one, ((gdouble)all - one) / EXTRA_PAGES);
+
+  g_ptr_array_unref (pages);
+}
+
+int
+main (int argc,
+      char *argv[])
+{
+  GtkInspectorInteractive *page;
+  GTypeModule *module;
+  gboolean finalized;
+
+  if (!gtk_init_check (&argc, &argv))
+    {
+      g_printerr ("Cannot open a display. For headless use, run under a virtual one "
+                  "such as xvfb-run, or set GDK_BACKEND=broadway with broadwayd running.\n");
+      return 2;
+    }
+
+  g_io_extension_point_register ("gtk-inspector-page");
+  module = gtk_inspector_fake_module_new ();
+  gtk_inspector_interactive_register (module);
+
+  g_print ("{\n  \"version\": \"%s\",\n  \"results\": [", PACKAGE_VERSION);
+
+  finalized = bench_startup ();
+  bench_pages ();
+
+  page = new_page ();
+  gtk_inspector_interactive_eval (page, "deep = { a: { b: { c: { d: { e: Gtk } } } } }", NULL);
+  drain_main_loop ();
+
+  bench_complete (page, "complete Gtk.", "Gtk.");
+  bench_complete (page, "complete window.", "window.");
+  bench_complete (page, "complete deep.a.b.c.d.e.", "deep.a.b.c.d.e.");
+  bench_eval (page);
+  bench_header (page);
+  bench_print (page);
+
+  g_print ("\n  ]\n}\n");
+
+  destroy_page (page);
+
+  return finalized ? 0 : 1;
+}
+
+// vim: set et sw=2 ts=2:
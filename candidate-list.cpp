@@ -0,0 +1,425 @@
+/*
+ * Copyright (c) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "candidate-list.h"
+
+/* Filtering runs on every keystroke over up to tens of thousands of
+ * names, so everything that doesn't depend on the pattern is worked
+ * out when the candidates are set: the names folded to lower case in
+ * one buffer, and a flag for each character that starts a word
+ * (after '_' or a digit, or an upper case letter after a lower case
+ * one). Matching a name is then one pass over its folded characters.
+ *
+ * The model only maps rows to the ranked candidates; it never emits
+ * row signals, which is why views are detached while it is filtered.
+ * In fixed height mode a view only measures and renders the rows
+ * that are visible. */
+
+/* What makes a match better: the first character of the name, the
+ * start of a word, following the previous match. Characters skipped
+ * and a longer name make it worse. */
+#define SCORE_MATCH         1
+#define SCORE_START        12
+#define SCORE_WORD_START    8
+#define SCORE_CONSECUTIVE   5
+#define SCORE_PREFIX       20
+#define PENALTY_GAP         1
+#define PENALTY_GAP_MAX     3
+
+typedef struct
+{
+  gint  score;
+  guint index;
+} Ranked;
+
+struct _GtkInspectorCandidateList
+{
+  GObject parent;
+
+  GPtrArray *names;
+  GString   *folded;     /* the names in lower case, each NUL terminated */
+  GArray    *offsets;    /* guint, start of each name in folded */
+  guint8    *word_start; /* parallel to folded */
+
+  GArray    *ranked;     /* Ranked, best first */
+  gint       stamp;
+};
+
+struct _GtkInspectorCandidateListClass
+{
+  GObjectClass parent_class;
+};
+
+static void gtk_inspector_candidate_list_tree_model_init (GtkTreeModelIface *iface);
+
+G_DEFINE_DYNAMIC_TYPE_EXTENDED (GtkInspectorCandidateList,
+                                gtk_inspector_candidate_list,
+                                G_TYPE_OBJECT,
+                                0,
+                                G_IMPLEMENT_INTERFACE_DYNAMIC (GTK_TYPE_TREE_MODEL,
+                                                               gtk_inspector_candidate_list_tree_model_init))
+
+static void
+gtk_inspector_candidate_list_init (GtkInspectorCandidateList *list)
+{
+  list->names = g_ptr_array_new_with_free_func (g_free);
+  list->folded = g_string_new (NULL);
+  list->offsets = g_array_new (FALSE, FALSE, sizeof (guint));
+  list->ranked = g_array_new (FALSE, FALSE, sizeof (Ranked));
+  list->stamp = g_random_int ();
+}
+
+static void
+gtk_inspector_candidate_list_finalize (GObject *object)
+{
+  GtkInspectorCandidateList *list = GTK_INSPECTOR_CANDIDATE_LIST (object);
+
+  g_ptr_array_unref (list->names);
+  g_string_free (list->folded, TRUE);
+  g_array_unref (list->offsets);
+  g_free (list->word_start);
+  g_array_unref (list->ranked);
+
+  G_OBJECT_CLASS (gtk_inspector_candidate_list_parent_class)->finalize (object);
+}
+
+static void
+gtk_inspector_candidate_list_class_init (GtkInspectorCandidateListClass *klass)
+{
+  G_OBJECT_CLASS (klass)->finalize = gtk_inspector_candidate_list_finalize;
+}
+
+static void
+gtk_inspector_candidate_list_class_finalize (GtkInspectorCandidateListClass *klass)
+{
+}
+
+void
+gtk_inspector_candidate_list_register (GTypeModule *module)
+{
+  gtk_inspector_candidate_list_register_type (module);
+}
+
+GtkInspectorCandidateList *
+gtk_inspector_candidate_list_new (void)
+{
+  return GTK_INSPECTOR_CANDIDATE_LIST (g_object_new (GTK_INSPECTOR_TYPE_CANDIDATE_LIST, NULL));
+}
+
+void
+gtk_inspector_candidate_list_set_candidates (GtkInspectorCandidateList *list,
+                                             GPtrArray                 *names)
+{
+  guint i;
+
+  g_ptr_array_unref (list->names);
+  list->names = names;
+  g_ptr_array_set_free_func (names, g_free);
+
+  g_string_truncate (list->folded, 0);
+  g_array_set_size (list->offsets, 0);
+  g_array_set_size (list->ranked, 0);
+  list->stamp++;
+
+  for (i = 0; i < names->len; i++)
+    {
+      const gchar *name = (const gchar *)names->pdata[i];
+      guint offset = list->folded->len;
+      const gchar *p;
+
+      g_array_append_val (list->offsets, offset);
+      for (p = name; *p; p++)
+        g_string_append_c (list->folded, g_ascii_tolower (*p));
+      g_string_append_c (list->folded, '\0');
+    }
+
+  g_free (list->word_start);
+  list->word_start = g_new0 (guint8, list->folded->len);
+
+  for (i = 0; i < names->len; i++)
+    {
+      const gchar *name = (const gchar *)names->pdata[i];
+      guint8 *flags = list->word_start + g_array_index (list->offsets, guint, i);
+      guint j;
+
+      for (j = 0; name[j]; j++)
+        flags[j] = j == 0 ||
+                   name[j - 1] == '_' ||
+                   (g_ascii_isdigit (name[j - 1]) && !g_ascii_isdigit (name[j])) ||
+                   (g_ascii_islower (name[j - 1]) && g_ascii_isupper (name[j]));
+    }
+}
+
+/* Greedy, left to right; returns G_MININT if pattern is not a
+ * subsequence of name */
+static gint
+score_candidate (const gchar  *pattern,
+                 guint         pattern_len,
+                 const gchar  *name,
+                 const guint8 *word_start)
+{
+  gint score = 0;
+  gint last = -2;
+  guint i, j;
+
+  if (strncmp (name, pattern, pattern_len) == 0)
+    score += SCORE_PREFIX;
+
+  for (i = 0, j = 0; i < pattern_len; i++, j++)
+    {
+      guint start = j;
+
+      while (name[j] && name[j] != pattern[i])
+        j++;
+      if (name[j] == '\0')
+        return G_MININT;
+
+      score += SCORE_MATCH;
+      if (j == 0)
+        score += SCORE_START;
+      else if (word_start[j])
+        score += SCORE_WORD_START;
+      if ((gint)j == last + 1)
+        score += SCORE_CONSECUTIVE;
+      else
+        score -= (gint)MIN ((j - start) * PENALTY_GAP, PENALTY_GAP_MAX);
+
+      last = j;
+    }
+
+  /* Of otherwise equal matches, the shorter name is likelier */
+  while (name[j])
+    j++;
+  score -= (gint)((j - pattern_len) / 4);
+
+  return score;
+}
+
+static gint
+compare_ranked (const void *a,
+                const void *b)
+{
+  const Ranked *ra = (const Ranked *)a;
+  const Ranked *rb = (const Ranked *)b;
+
+  if (ra->score != rb->score)
+    return (rb->score > ra->score) - (rb->score < ra->score);
+
+  return (ra->index > rb->index) - (ra->index < rb->index);
+}
+
+guint
+gtk_inspector_candidate_list_filter (GtkInspectorCandidateList *list,
+                                     const gchar               *pattern)
+{
+  gchar *folded;
+  guint pattern_len;
+  guint i;
+
+  folded = g_ascii_strdown (pattern, -1);
+  pattern_len = strlen (folded);
+
+  g_array_set_size (list->ranked, 0);
+  list->stamp++;
+
+  for (i = 0; i < list->names->len; i++)
+    {
+      guint offset = g_array_index (list->offsets, guint, i);
+      Ranked ranked;
+
+      ranked.score = score_candidate (folded, pattern_len,
+                                      list->folded->str + offset,
+                                      list->word_start + offset);
+      if (ranked.score == G_MININT)
+        continue;
+
+      ranked.index = i;
+      g_array_append_val (list->ranked, ranked);
+    }
+
+  /* An empty pattern leaves the candidates in their own order */
+  if (pattern_len > 0)
+    qsort (list->ranked->data, list->ranked->len, sizeof (Ranked), compare_ranked);
+
+  g_free (folded);
+
+  return list->ranked->len;
+}
+
+const gchar *
+gtk_inspector_candidate_list_get (GtkInspectorCandidateList *list,
+                                  guint                      row)
+{
+  g_return_val_if_fail (row < list->ranked->len, NULL);
+
+  return (const gchar *)list->names->pdata[g_array_index (list->ranked, Ranked, row).index];
+}
+
+guint
+gtk_inspector_candidate_list_get_n_rows (GtkInspectorCandidateList *list)
+{
+  return list->ranked->len;
+}
+
+/* GtkTreeModel: an iter holds its row in user_data */
+
+static gboolean
+set_iter (GtkInspectorCandidateList *list,
+          GtkTreeIter               *iter,
+          guint                      row)
+{
+  if (row >= list->ranked->len)
+    {
+      iter->stamp = 0;
+      return FALSE;
+    }
+
+  iter->stamp = list->stamp;
+  iter->user_data = GUINT_TO_POINTER (row);
+  return TRUE;
+}
+
+static GtkTreeModelFlags
+candidate_list_get_flags (GtkTreeModel *model)
+{
+  return (GtkTreeModelFlags)(GTK_TREE_MODEL_LIST_ONLY | GTK_TREE_MODEL_ITERS_PERSIST);
+}
+
+static gint
+candidate_list_get_n_columns (GtkTreeModel *model)
+{
+  return 1;
+}
+
+static GType
+candidate_list_get_column_type (GtkTreeModel *model,
+                                gint          column)
+{
+  return G_TYPE_STRING;
+}
+
+static gboolean
+candidate_list_get_iter (GtkTreeModel *model,
+                         GtkTreeIter  *iter,
+                         GtkTreePath  *path)
+{
+  if (gtk_tree_path_get_depth (path) != 1)
+    return FALSE;
+
+  return set_iter (GTK_INSPECTOR_CANDIDATE_LIST (model), iter,
+                   gtk_tree_path_get_indices (path)[0]);
+}
+
+static GtkTreePath *
+candidate_list_get_path (GtkTreeModel *model,
+                         GtkTreeIter  *iter)
+{
+  return gtk_tree_path_new_from_indices (GPOINTER_TO_UINT (iter->user_data), -1);
+}
+
+static void
+candidate_list_get_value (GtkTreeModel *model,
+                          GtkTreeIter  *iter,
+                          gint          column,
+                          GValue       *value)
+{
+  GtkInspectorCandidateList *list = GTK_INSPECTOR_CANDIDATE_LIST (model);
+
+  g_value_init (value, G_TYPE_STRING);
+  g_value_set_static_string (value, gtk_inspector_candidate_list_get (list, GPOINTER_TO_UINT (iter->user_data)));
+}
+
+static gboolean
+candidate_list_iter_next (GtkTreeModel *model,
+                          GtkTreeIter  *iter)
+{
+  return set_iter (GTK_INSPECTOR_CANDIDATE_LIST (model), iter,
+                   GPOINTER_TO_UINT (iter->user_data) + 1);
+}
+
+static gboolean
+candidate_list_iter_nth_child (GtkTreeModel *model,
+                               GtkTreeIter  *iter,
+                               GtkTreeIter  *parent,
+                               gint          n)
+{
+  if (parent != NULL)
+    {
+      iter->stamp = 0;
+      return FALSE;
+    }
+
+  return set_iter (GTK_INSPECTOR_CANDIDATE_LIST (model), iter, n);
+}
+
+static gboolean
+candidate_list_iter_children (GtkTreeModel *model,
+                              GtkTreeIter  *iter,
+                              GtkTreeIter  *parent)
+{
+  return candidate_list_iter_nth_child (model, iter, parent, 0);
+}
+
+static gboolean
+candidate_list_iter_has_child (GtkTreeModel *model,
+                               GtkTreeIter  *iter)
+{
+  return FALSE;
+}
+
+static gint
+candidate_list_iter_n_children (GtkTreeModel *model,
+                                GtkTreeIter  *iter)
+{
+  if (iter != NULL)
+    return 0;
+
+  return GTK_INSPECTOR_CANDIDATE_LIST (model)->ranked->len;
+}
+
+static gboolean
+candidate_list_iter_parent (GtkTreeModel *model,
+                            GtkTreeIter  *iter,
+                            GtkTreeIter  *child)
+{
+  iter->stamp = 0;
+  return FALSE;
+}
+
+static void
+gtk_inspector_candidate_list_tree_model_init (GtkTreeModelIface *iface)
+{
+  iface->get_flags = candidate_list_get_flags;
+  iface->get_n_columns = candidate_list_get_n_columns;
+  iface->get_column_type = candidate_list_get_column_type;
+  iface->get_iter = candidate_list_get_iter;
+  iface->get_path = candidate_list_get_path;
+  iface->get_value = candidate_list_get_value;
+  iface->iter_next = candidate_list_iter_next;
+  iface->iter_children = candidate_list_iter_children;
+  iface->iter_has_child = candidate_list_iter_has_child;
+  iface->iter_n_children = candidate_list_iter_n_children;
+  iface->iter_nth_child = candidate_list_iter_nth_child;
+  iface->iter_parent = candidate_list_iter_parent;
+}
+
+// vim: set et sw=2 ts=2:
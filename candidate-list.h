@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _GTK_INSPECTOR_CANDIDATE_LIST_H_
+#define _GTK_INSPECTOR_CANDIDATE_LIST_H_
+
+#include <gtk/gtk.h>
+
+#define GTK_INSPECTOR_TYPE_CANDIDATE_LIST     (gtk_inspector_candidate_list_get_type ())
+#define GTK_INSPECTOR_CANDIDATE_LIST(obj)     (G_TYPE_CHECK_INSTANCE_CAST ((obj), GTK_INSPECTOR_TYPE_CANDIDATE_LIST, GtkInspectorCandidateList))
+#define GTK_INSPECTOR_IS_CANDIDATE_LIST(obj)  (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GTK_INSPECTOR_TYPE_CANDIDATE_LIST))
+
+G_BEGIN_DECLS
+
+/* The completion candidates that match a pattern, best first, as a
+ * list model with one string column. The model holds no rows of its
+ * own, only the ranking, so views should use fixed height mode and
+ * be detached from it while it is filtered. */
+typedef struct _GtkInspectorCandidateList GtkInspectorCandidateList;
+typedef struct _GtkInspectorCandidateListClass GtkInspectorCandidateListClass;
+
+GType
+gtk_inspector_candidate_list_get_type (void);
+
+void
+gtk_inspector_candidate_list_register (GTypeModule *module);
+
+GtkInspectorCandidateList *
+gtk_inspector_candidate_list_new (void);
+
+/* Takes ownership of names */
+void
+gtk_inspector_candidate_list_set_candidates (GtkInspectorCandidateList *list,
+                                             GPtrArray                 *names);
+
+/* Ranks the candidates the pattern is a subsequence of, ignoring case,
+ * and returns how many there are */
+guint
+gtk_inspector_candidate_list_filter (GtkInspectorCandidateList *list,
+                                     const gchar               *pattern);
+
+const gchar *
+gtk_inspector_candidate_list_get (GtkInspectorCandidateList *list,
+                                  guint                      row);
+
+guint
+gtk_inspector_candidate_list_get_n_rows (GtkInspectorCandidateList *list);
+
+G_END_DECLS
+
+#endif // _GTK_INSPECTOR_CANDIDATE_LIST_H_
+
+// vim: set et sw=2 ts=2:
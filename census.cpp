@@ -0,0 +1,441 @@
+/*
+ * Copyright (c) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdlib.h>
+
+#include "census.h"
+
+/* The counting itself is done by GObject when GOBJECT_DEBUG contains
+ * instance-count: one atomic increment or decrement per instance
+ * created or finalized, cheap enough to leave on. GObject only looks
+ * at GOBJECT_DEBUG if GLib was built with G_ENABLE_DEBUG, which most
+ * distributions' builds are not, so whether counting is on is checked
+ * on an instance of our own. Taking a census walks the type tree below
+ * GObject and reads the counts.
+ *
+ * Otherwise we count instances of the types we are asked to watch. The
+ * constructed vfunc of a watched class, and of its subclasses already
+ * initialized, is replaced by census_constructed(), which counts the
+ * instance by its exact type and then calls the function it replaced.
+ * Subclasses initialized later inherit it, or chain up to it. The mark
+ * it leaves on the instance is freed when the instance is finalized,
+ * and takes the count down again. Instances from before the watch
+ * started are not seen.
+ *
+ * census_constructed() can't tell which class it was called through,
+ * so it keeps where the chain up will land next on the instance, and
+ * works out which function to call from that. */
+
+typedef struct
+{
+  GType type;
+  gint  count;
+} CensusEntry;
+
+struct _GtkInspectorCensus
+{
+  GArray  *entries;   /* CensusEntry, sorted by type */
+  guint    total;
+  gboolean watched;   /* counted by us, only for the watched types */
+};
+
+typedef void (*ConstructedFunc) (GObject *object);
+
+static GMutex watch_lock;
+static GHashTable *originals;    /* GType -> ConstructedFunc replaced */
+static GHashTable *watch_counts; /* exact GType -> live instances */
+static GQuark counted_quark;
+static GQuark chain_quark;
+
+gboolean
+gtk_inspector_census_is_available (void)
+{
+#if GLIB_CHECK_VERSION (2, 44, 0)
+  static const GDebugKey keys[] = {
+    { "instance-count", 1 },
+  };
+
+  static gint available = -1;
+
+  if (available == -1)
+    {
+      GObject *probe;
+
+      /* The same check GObject makes when it initializes */
+      available = g_parse_debug_string (g_getenv ("GOBJECT_DEBUG"), keys, G_N_ELEMENTS (keys)) != 0;
+
+      /* Without G_ENABLE_DEBUG, GLib reports 0 for every type */
+      if (available)
+        {
+          probe = (GObject *)g_object_new (G_TYPE_OBJECT, NULL);
+          available = g_type_get_instance_count (G_TYPE_OBJECT) > 0;
+          g_object_unref (probe);
+        }
+    }
+
+  return available;
+#else
+  return FALSE;
+#endif
+}
+
+static void
+census_constructed (GObject *object);
+
+/* What the class of type does in constructed, us aside */
+static ConstructedFunc
+effective_original (GType type)
+{
+  while (type != G_TYPE_INVALID)
+    {
+      ConstructedFunc func = G_OBJECT_CLASS (g_type_class_peek (type))->constructed;
+
+      if (func != census_constructed)
+        return func;
+
+      /* Otherwise replaced by us, or inherited from a class we replaced */
+      func = (ConstructedFunc)g_hash_table_lookup (originals, GSIZE_TO_POINTER (type));
+      if (func != NULL)
+        return func;
+
+      type = g_type_parent (type);
+    }
+
+  g_assert_not_reached ();
+  return NULL;
+}
+
+static void
+uncount (gpointer data)
+{
+  gpointer key = data;
+
+  g_mutex_lock (&watch_lock);
+  g_hash_table_insert (watch_counts, key,
+                       GINT_TO_POINTER (GPOINTER_TO_INT (g_hash_table_lookup (watch_counts, key)) - 1));
+  g_mutex_unlock (&watch_lock);
+}
+
+static void
+census_constructed (GObject *object)
+{
+  GType start, level, definer, parent;
+  ConstructedFunc original;
+  gboolean outermost;
+  gpointer key = NULL;
+
+  start = (GType)GPOINTER_TO_SIZE (g_object_get_qdata (object, chain_quark));
+  outermost = start == G_TYPE_INVALID;
+  if (outermost)
+    start = G_OBJECT_TYPE (object);
+
+  /* The first class from start up that has us is the one we came
+   * through */
+  level = start;
+  while (level != G_TYPE_INVALID &&
+         G_OBJECT_CLASS (g_type_class_peek (level))->constructed != census_constructed)
+    level = g_type_parent (level);
+
+  /* A class that chained up past its parent; start over */
+  if (level == G_TYPE_INVALID)
+    for (level = G_OBJECT_TYPE (object);
+         G_OBJECT_CLASS (g_type_class_peek (level))->constructed != census_constructed;
+         level = g_type_parent (level))
+      ;
+
+  g_mutex_lock (&watch_lock);
+
+  original = effective_original (level);
+
+  /* That function chains up from the class that defined it */
+  definer = level;
+  for (parent = g_type_parent (definer);
+       parent != G_TYPE_INVALID && effective_original (parent) == original;
+       parent = g_type_parent (definer))
+    definer = parent;
+
+  if (outermost)
+    {
+      key = GSIZE_TO_POINTER (G_OBJECT_TYPE (object));
+      g_hash_table_insert (watch_counts, key,
+                           GINT_TO_POINTER (GPOINTER_TO_INT (g_hash_table_lookup (watch_counts, key)) + 1));
+    }
+
+  g_mutex_unlock (&watch_lock);
+
+  if (outermost)
+    g_object_set_qdata_full (object, counted_quark, key, uncount);
+
+  g_object_set_qdata (object, chain_quark, GSIZE_TO_POINTER (g_type_parent (definer)));
+  original (object);
+
+  if (outermost)
+    g_object_set_qdata (object, chain_quark, NULL);
+}
+
+static void
+replace_constructed (GType type)
+{
+  GObjectClass *klass = (GObjectClass *)g_type_class_peek (type);
+  GType *children;
+  guint i, n_children;
+
+  /* Classes not initialized yet will copy their parent's */
+  if (klass == NULL)
+    return;
+
+  if (klass->constructed != census_constructed)
+    {
+      g_mutex_lock (&watch_lock);
+      g_hash_table_insert (originals, GSIZE_TO_POINTER (type), (gpointer)klass->constructed);
+      g_mutex_unlock (&watch_lock);
+      klass->constructed = census_constructed;
+    }
+
+  children = g_type_children (type, &n_children);
+  for (i = 0; i < n_children; i++)
+    replace_constructed (children[i]);
+  g_free (children);
+}
+
+gboolean
+gtk_inspector_census_watch (GType type)
+{
+  if (!g_type_is_a (type, G_TYPE_OBJECT) || G_TYPE_IS_INTERFACE (type))
+    return FALSE;
+
+  if (originals == NULL)
+    {
+      originals = g_hash_table_new (NULL, NULL);
+      watch_counts = g_hash_table_new (NULL, NULL);
+      counted_quark = g_quark_from_static_string ("gtk-inspector-census-counted");
+      chain_quark = g_quark_from_static_string ("gtk-inspector-census-chain");
+    }
+
+  /* Kept for good, since the class is modified */
+  g_type_class_ref (type);
+  replace_constructed (type);
+
+  return TRUE;
+}
+
+gboolean
+gtk_inspector_census_is_counting (void)
+{
+  return gtk_inspector_census_is_available () || originals != NULL;
+}
+
+static void
+add_watched (GtkInspectorCensus *census)
+{
+  GHashTableIter iter;
+  gpointer key, value;
+  CensusEntry entry;
+
+  g_mutex_lock (&watch_lock);
+  g_hash_table_iter_init (&iter, watch_counts);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      entry.type = (GType)GPOINTER_TO_SIZE (key);
+      entry.count = GPOINTER_TO_INT (value);
+      if (entry.count > 0)
+        {
+          g_array_append_val (census->entries, entry);
+          census->total += entry.count;
+        }
+    }
+  g_mutex_unlock (&watch_lock);
+}
+
+static void
+add_type (GtkInspectorCensus *census,
+          GType               type)
+{
+  GType *children;
+  guint i, n_children;
+
+#if GLIB_CHECK_VERSION (2, 44, 0)
+  CensusEntry entry;
+
+  entry.type = type;
+  entry.count = g_type_get_instance_count (type);
+  if (entry.count > 0)
+    {
+      g_array_append_val (census->entries, entry);
+      census->total += entry.count;
+    }
+#endif
+
+  children = g_type_children (type, &n_children);
+  for (i = 0; i < n_children; i++)
+    add_type (census, children[i]);
+  g_free (children);
+}
+
+static gint
+compare_by_type (gconstpointer a,
+                 gconstpointer b)
+{
+  const CensusEntry *ea = (const CensusEntry *)a;
+  const CensusEntry *eb = (const CensusEntry *)b;
+
+  return (ea->type > eb->type) - (ea->type < eb->type);
+}
+
+GtkInspectorCensus *
+gtk_inspector_census_take (void)
+{
+  GtkInspectorCensus *census;
+
+  census = g_new0 (GtkInspectorCensus, 1);
+  census->entries = g_array_new (FALSE, FALSE, sizeof (CensusEntry));
+
+  if (gtk_inspector_census_is_available ())
+    {
+      add_type (census, G_TYPE_OBJECT);
+    }
+  else
+    {
+      census->watched = TRUE;
+      if (originals != NULL)
+        add_watched (census);
+    }
+  g_array_sort (census->entries, compare_by_type);
+
+  return census;
+}
+
+void
+gtk_inspector_census_free (GtkInspectorCensus *census)
+{
+  g_array_unref (census->entries);
+  g_free (census);
+}
+
+static gint
+compare_by_magnitude (gconstpointer a,
+                      gconstpointer b)
+{
+  gint ca = abs (((const CensusEntry *)a)->count);
+  gint cb = abs (((const CensusEntry *)b)->count);
+
+  if (ca != cb)
+    return (cb > ca) - (cb < ca);
+
+  return g_strcmp0 (g_type_name (((const CensusEntry *)a)->type),
+                    g_type_name (((const CensusEntry *)b)->type));
+}
+
+static void
+append_entries (GString *report,
+                GArray  *entries,
+                guint    limit,
+                gboolean sign)
+{
+  guint i;
+
+  g_array_sort (entries, compare_by_magnitude);
+
+  for (i = 0; i < entries->len && i < limit; i++)
+    {
+      const CensusEntry *entry = &g_array_index (entries, CensusEntry, i);
+
+      g_string_append_printf (report, sign ? "\n  %+8d %s" : "\n  %8d %s",
+                              entry->count, g_type_name (entry->type));
+    }
+
+  if (entries->len > limit)
+    g_string_append_printf (report, "\n  and %u more types", entries->len - limit);
+}
+
+gchar *
+gtk_inspector_census_report (const GtkInspectorCensus *census,
+                             guint                     limit)
+{
+  GString *report;
+  GArray *entries;
+
+  report = g_string_new (NULL);
+  g_string_append_printf (report, "%u instances of %u types",
+                          census->total, census->entries->len);
+  if (census->watched)
+    g_string_append (report, ", created since their type was watched");
+
+  entries = g_array_sized_new (FALSE, FALSE, sizeof (CensusEntry), census->entries->len);
+  g_array_append_vals (entries, census->entries->data, census->entries->len);
+  append_entries (report, entries, limit, FALSE);
+  g_array_unref (entries);
+
+  return g_string_free (report, FALSE);
+}
+
+gchar *
+gtk_inspector_census_diff (const GtkInspectorCensus *before,
+                           const GtkInspectorCensus *after,
+                           guint                     limit)
+{
+  GString *report;
+  GArray *changes;
+  guint i, j;
+
+  changes = g_array_new (FALSE, FALSE, sizeof (CensusEntry));
+
+  /* Both are sorted by type, so this is a merge */
+  i = j = 0;
+  while (i < before->entries->len || j < after->entries->len)
+    {
+      const CensusEntry *b = i < before->entries->len ? &g_array_index (before->entries, CensusEntry, i) : NULL;
+      const CensusEntry *a = j < after->entries->len ? &g_array_index (after->entries, CensusEntry, j) : NULL;
+      CensusEntry change;
+
+      if (a == NULL || (b != NULL && b->type < a->type))
+        {
+          change.type = b->type;
+          change.count = -b->count;
+          i++;
+        }
+      else if (b == NULL || a->type < b->type)
+        {
+          change = *a;
+          j++;
+        }
+      else
+        {
+          change.type = a->type;
+          change.count = a->count - b->count;
+          i++;
+          j++;
+        }
+
+      if (change.count != 0)
+        g_array_append_val (changes, change);
+    }
+
+  report = g_string_new (NULL);
+  g_string_append_printf (report, "%+d instances, %u types changed",
+                          (gint)after->total - (gint)before->total, changes->len);
+  if (before->watched || after->watched)
+    g_string_append (report, ", of the watched types");
+  append_entries (report, changes, limit, TRUE);
+  g_array_unref (changes);
+
+  return g_string_free (report, FALSE);
+}
+
+// vim: set et sw=2 ts=2:
@@ -0,0 +1,65 @@
+/*
+ * Copyright (c) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _GTK_INSPECTOR_CENSUS_H_
+#define _GTK_INSPECTOR_CENSUS_H_
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+/* Live instance counts of every GObject type with instances */
+typedef struct _GtkInspectorCensus GtkInspectorCensus;
+
+/* Counts are only kept if the application was started with
+ * GOBJECT_DEBUG=instance-count, against a GLib built with
+ * G_ENABLE_DEBUG */
+gboolean
+gtk_inspector_census_is_available (void);
+
+/* Without those, instances of type and its subtypes are counted by us
+ * from now on. Returns FALSE if type is not an object type. Main
+ * thread only; instances may be created anywhere. */
+gboolean
+gtk_inspector_census_watch (GType type);
+
+/* Whether a census has anything to count, one way or the other */
+gboolean
+gtk_inspector_census_is_counting (void);
+
+GtkInspectorCensus *
+gtk_inspector_census_take (void);
+
+void
+gtk_inspector_census_free (GtkInspectorCensus *census);
+
+/* The limit types with the most instances */
+gchar *
+gtk_inspector_census_report (const GtkInspectorCensus *census,
+                             guint                     limit);
+
+/* The limit types whose counts changed most from before to after */
+gchar *
+gtk_inspector_census_diff (const GtkInspectorCensus *before,
+                           const GtkInspectorCensus *after,
+                           guint                     limit);
+
+G_END_DECLS
+
+#endif // _GTK_INSPECTOR_CENSUS_H_
+
+// vim: set et sw=2 ts=2:
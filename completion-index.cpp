@@ -0,0 +1,304 @@
+/*
+ * Copyright (c) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <girepository.h>
+
+#include "completion-index.h"
+
+/* Per-GType member tables, one cache for instances (properties and
+ * methods along the parent chain) and one for classes (static
+ * functions only). Like everything here, only ever touched from the
+ * main thread. */
+static GHashTable *type_tables[2];
+
+/* Namespace tables, built on the main thread a chunk of infos at a
+ * time from a low priority idle. GIRepository is not thread safe and
+ * gjs uses the default repository from the main thread, so it can't
+ * be walked from anywhere else. */
+static GHashTable *namespace_tables;
+
+/* Infos indexed per idle iteration */
+#define WARM_CHUNK 200
+
+/* The namespaces the REPL imports up front */
+static const struct {
+  const gchar *ns;
+  const gchar *version;
+} warm_namespaces[] = {
+  { "GLib", "2.0" },
+  { "GObject", "2.0" },
+  { "Gio", "2.0" },
+  { "Pango", "1.0" },
+  { "cairo", "1.0" },
+  { "Gtk", "3.0" },
+};
+
+static gint
+compare_names (gconstpointer a,
+               gconstpointer b)
+{
+  return strcmp (*(const gchar **)a, *(const gchar **)b);
+}
+
+static GtkInspectorNameTable *
+name_table_new_from_array (GPtrArray *names)
+{
+  GtkInspectorNameTable *table;
+  guint i, n;
+
+  g_ptr_array_sort (names, compare_names);
+
+  /* The strings are interned, so duplicates are adjacent and equal
+   * as pointers */
+  n = 0;
+  for (i = 0; i < names->len; i++)
+    {
+      if (n > 0 && names->pdata[i] == names->pdata[n - 1])
+        continue;
+      names->pdata[n++] = names->pdata[i];
+    }
+
+  table = g_new0 (GtkInspectorNameTable, 1);
+  table->n_names = n;
+  table->names = (const gchar **)g_ptr_array_free (names, FALSE);
+
+  return table;
+}
+
+static void
+add_object_info (GPtrArray    *names,
+                 GIObjectInfo *info,
+                 gboolean      for_object)
+{
+  gint i, n;
+
+  if (for_object)
+    {
+      n = g_object_info_get_n_properties (info);
+      for (i = 0; i < n; i++)
+        {
+          GIPropertyInfo *prop = g_object_info_get_property (info, i);
+          gchar *name = g_strdelimit (g_strdup (g_base_info_get_name (prop)), "-", '_');
+
+          g_ptr_array_add (names, (gpointer)g_intern_string (name));
+          g_free (name);
+          g_base_info_unref (prop);
+        }
+    }
+
+  n = g_object_info_get_n_methods (info);
+  for (i = 0; i < n; i++)
+    {
+      GIFunctionInfo *method = g_object_info_get_method (info, i);
+      gboolean is_method = (g_function_info_get_flags (method) & GI_FUNCTION_IS_METHOD) != 0;
+
+      if (is_method == for_object)
+        g_ptr_array_add (names, (gpointer)g_intern_string (g_base_info_get_name (method)));
+      g_base_info_unref (method);
+    }
+
+  if (for_object)
+    {
+      GIObjectInfo *parent = g_object_info_get_parent (info);
+
+      if (parent)
+        {
+          add_object_info (names, parent, for_object);
+          g_base_info_unref (parent);
+        }
+    }
+}
+
+static GtkInspectorNameTable *
+build_type_table (GType    type,
+                  gboolean for_object)
+{
+  GIRepository *repo = g_irepository_get_default ();
+  GPtrArray *names = g_ptr_array_new ();
+
+  /* Types without introspection data (e.g. application subclasses)
+   * complete like their nearest introspected ancestor */
+  while (type != G_TYPE_INVALID)
+    {
+      GIBaseInfo *info = g_irepository_find_by_gtype (repo, type);
+
+      if (info)
+        {
+          if (g_base_info_get_type (info) == GI_INFO_TYPE_OBJECT)
+            add_object_info (names, (GIObjectInfo *)info, for_object);
+          g_base_info_unref (info);
+          break;
+        }
+
+      if (!for_object || type == G_TYPE_OBJECT)
+        break;
+
+      type = g_type_parent (type);
+    }
+
+  return name_table_new_from_array (names);
+}
+
+const GtkInspectorNameTable *
+gtk_inspector_completion_lookup_type (GType    type,
+                                      gboolean for_object)
+{
+  GHashTable **cache = &type_tables[for_object ? 1 : 0];
+  GtkInspectorNameTable *table;
+
+  if (*cache == NULL)
+    *cache = g_hash_table_new (NULL, NULL);
+
+  table = (GtkInspectorNameTable *)g_hash_table_lookup (*cache, GSIZE_TO_POINTER (type));
+  if (table == NULL)
+    {
+      table = build_type_table (type, for_object);
+      g_hash_table_insert (*cache, GSIZE_TO_POINTER (type), table);
+    }
+
+  return table;
+}
+
+typedef struct
+{
+  guint      ns;          /* index into warm_namespaces */
+  gint       info;        /* next info to index */
+  gint       n_infos;
+  GPtrArray *names;       /* NULL until the namespace is loaded */
+} WarmState;
+
+static gboolean
+warm_namespaces_step (gpointer data)
+{
+  WarmState *state = (WarmState *)data;
+  GIRepository *repo = g_irepository_get_default ();
+  const gchar *ns;
+  gint end;
+
+  if (state->ns == G_N_ELEMENTS (warm_namespaces))
+    {
+      g_free (state);
+      return G_SOURCE_REMOVE;
+    }
+
+  ns = warm_namespaces[state->ns].ns;
+
+  /* Loading the typelib gets an iteration of its own */
+  if (state->names == NULL)
+    {
+      GError *error = NULL;
+
+      if (!g_irepository_require (repo, ns, warm_namespaces[state->ns].version,
+                                  (GIRepositoryLoadFlags)0, &error))
+        {
+          g_debug ("Not indexing namespace %s: %s", ns, error->message);
+          g_clear_error (&error);
+          state->ns++;
+          return G_SOURCE_CONTINUE;
+        }
+
+      state->info = 0;
+      state->n_infos = g_irepository_get_n_infos (repo, ns);
+      state->names = g_ptr_array_sized_new (state->n_infos);
+      return G_SOURCE_CONTINUE;
+    }
+
+  end = MIN (state->info + WARM_CHUNK, state->n_infos);
+  for (; state->info < end; state->info++)
+    {
+      GIBaseInfo *info = g_irepository_get_info (repo, ns, state->info);
+
+      g_ptr_array_add (state->names, (gpointer)g_intern_string (g_base_info_get_name (info)));
+      g_base_info_unref (info);
+    }
+
+  if (state->info == state->n_infos)
+    {
+      g_hash_table_insert (namespace_tables, (gpointer)g_intern_string (ns),
+                           name_table_new_from_array (state->names));
+      state->names = NULL;
+      state->ns++;
+    }
+
+  return G_SOURCE_CONTINUE;
+}
+
+/* Loads the typelibs the REPL pre-imports and indexes every name in
+ * them, in small steps so the main loop of the inspected application
+ * is never held up for long */
+void
+gtk_inspector_completion_warm_namespaces (void)
+{
+  if (namespace_tables != NULL)
+    return;
+
+  namespace_tables = g_hash_table_new (g_str_hash, g_str_equal);
+  g_idle_add_full (G_PRIORITY_LOW, warm_namespaces_step, g_new0 (WarmState, 1), NULL);
+}
+
+/* Returns NULL if ns is not indexed or the index is still being built */
+const GtkInspectorNameTable *
+gtk_inspector_completion_lookup_namespace (const gchar *ns)
+{
+  if (namespace_tables == NULL)
+    return NULL;
+
+  return (const GtkInspectorNameTable *)g_hash_table_lookup (namespace_tables, ns);
+}
+
+void
+gtk_inspector_name_table_range (const GtkInspectorNameTable *table,
+                                const gchar                 *prefix,
+                                guint                       *begin,
+                                guint                       *end)
+{
+  gsize prefix_len = strlen (prefix);
+  guint lo, hi;
+
+  /* First name >= prefix */
+  lo = 0;
+  hi = table->n_names;
+  while (lo < hi)
+    {
+      guint mid = lo + (hi - lo) / 2;
+
+      if (strcmp (table->names[mid], prefix) < 0)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+  *begin = lo;
+
+  /* First name past the run that starts with prefix */
+  hi = table->n_names;
+  while (lo < hi)
+    {
+      guint mid = lo + (hi - lo) / 2;
+
+      if (strncmp (table->names[mid], prefix, prefix_len) == 0)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+  *end = lo;
+}
+
+// vim: set et sw=2 ts=2:
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _GTK_INSPECTOR_COMPLETION_INDEX_H_
+#define _GTK_INSPECTOR_COMPLETION_INDEX_H_
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+/* A sorted, deduplicated array of interned names. Tables are never
+ * freed once built, so the strings can be handed out without copying. */
+typedef struct _GtkInspectorNameTable
+{
+  guint         n_names;
+  const gchar **names;
+} GtkInspectorNameTable;
+
+const GtkInspectorNameTable *
+gtk_inspector_completion_lookup_type (GType    type,
+                                      gboolean for_object);
+
+void
+gtk_inspector_completion_warm_namespaces (void);
+
+const GtkInspectorNameTable *
+gtk_inspector_completion_lookup_namespace (const gchar *ns);
+
+void
+gtk_inspector_name_table_range (const GtkInspectorNameTable *table,
+                                const gchar                 *prefix,
+                                guint                       *begin,
+                                guint                       *end);
+
+G_END_DECLS
+
+#endif // _GTK_INSPECTOR_COMPLETION_INDEX_H_
+
+// vim: set et sw=2 ts=2:
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "fake-module.h"
+
+typedef struct _GFakeModule GFakeModule;
+typedef struct _GFakeModuleClass GFakeModuleClass;
+
+struct _GFakeModule {
+  GTypeModule parent_instance;
+};
+
+struct _GFakeModuleClass
+{
+  GTypeModuleClass parent_class;
+};
+
+static void
+g_fake_module_init (GFakeModule *module)
+{
+}
+
+static gboolean
+g_fake_module_load_module (GTypeModule *gmodule)
+{
+  return TRUE;
+}
+
+static void
+g_fake_module_unload_module (GTypeModule *gmodule)
+{
+}
+
+static void
+g_fake_module_class_init (GFakeModuleClass *class)
+{
+  GTypeModuleClass *type_module_class = G_TYPE_MODULE_CLASS (class);
+
+  type_module_class->load    = g_fake_module_load_module;
+  type_module_class->unload  = g_fake_module_unload_module;
+}
+
+G_DEFINE_TYPE (GFakeModule, g_fake_module, G_TYPE_TYPE_MODULE);
+
+GTypeModule *
+gtk_inspector_fake_module_new (void)
+{
+  return G_TYPE_MODULE (g_object_new (g_fake_module_get_type (), NULL));
+}
+
+// vim: set et sw=2 ts=2:
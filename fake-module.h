@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _GTK_INSPECTOR_FAKE_MODULE_H_
+#define _GTK_INSPECTOR_FAKE_MODULE_H_
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+/* A type module that is always loaded, for registering the page when
+ * it isn't loaded by GIO as an inspector module */
+GTypeModule *
+gtk_inspector_fake_module_new (void);
+
+G_END_DECLS
+
+#endif // _GTK_INSPECTOR_FAKE_MODULE_H_
+
+// vim: set et sw=2 ts=2:
@@ -0,0 +1,345 @@
+/*
+ * Copyright (c) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "frame-monitor.h"
+
+/* Frames are timed from the frame clock signals: ::before-paint starts
+ * a frame, and each of ::update, ::layout and ::paint ends a phase.
+ * The phase handlers are connected after the default ones, so a phase
+ * covers the handlers of the toolkit that ran in it. Records go into a
+ * ring allocated up front, so recording a frame allocates nothing. */
+
+enum {
+  PHASE_UPDATE,
+  PHASE_LAYOUT,
+  PHASE_PAINT,
+  N_PHASES
+};
+
+static const gchar *phase_names[N_PHASES] = { "update", "layout", "paint" };
+
+typedef struct
+{
+  gint64 counter;
+  gint64 start;              /* monotonic time, in microseconds */
+  gint32 gap;                /* since the start of the previous frame */
+  gint32 total;              /* ::before-paint to ::after-paint */
+  gint32 phases[N_PHASES];
+  gint32 refresh_interval;
+} FrameRecord;
+
+enum {
+  HANDLER_FRAME_START,
+  HANDLER_BEFORE_PAINT,
+  HANDLER_UPDATE,
+  HANDLER_LAYOUT,
+  HANDLER_PAINT,
+  HANDLER_AFTER_PAINT,
+  N_HANDLERS
+};
+
+struct _GtkInspectorFrameMonitor
+{
+  GdkFrameClock *clock;
+  gulong         handlers[N_HANDLERS];
+
+  FrameRecord   *records;
+  guint          capacity;
+  guint          head;       /* next slot to write */
+  guint          count;
+  guint64        n_frames;   /* including the ones overwritten */
+
+  FrameRecord    current;
+  gboolean       in_frame;
+  gint64         mark;
+  gint64         last_start;
+};
+
+/* Upper bounds of the histogram buckets, in microseconds; the last
+ * bucket takes everything longer */
+static const gint32 bucket_limits[] = {
+  2000, 4000, 8000, 12000, 16667, 25000, 33333, 50000, 100000
+};
+#define N_BUCKETS (G_N_ELEMENTS (bucket_limits) + 1)
+#define BAR_WIDTH 40
+#define MAX_MISSED_LISTED 50
+
+static void
+frame_start (GdkFrameClock            *clock,
+             GtkInspectorFrameMonitor *monitor)
+{
+  gint64 now = g_get_monotonic_time ();
+
+  memset (&monitor->current, 0, sizeof (FrameRecord));
+  monitor->current.counter = gdk_frame_clock_get_frame_counter (clock);
+  monitor->current.start = now;
+  if (monitor->last_start != 0)
+    monitor->current.gap = now - monitor->last_start;
+  monitor->last_start = now;
+  monitor->in_frame = TRUE;
+}
+
+static void
+before_paint (GdkFrameClock            *clock,
+              GtkInspectorFrameMonitor *monitor)
+{
+  monitor->mark = g_get_monotonic_time ();
+}
+
+static void
+end_phase (GtkInspectorFrameMonitor *monitor,
+           guint                     phase)
+{
+  gint64 now = g_get_monotonic_time ();
+
+  if (!monitor->in_frame)
+    return;
+
+  /* += since layout can be run more than once per frame */
+  monitor->current.phases[phase] += now - monitor->mark;
+  monitor->mark = now;
+}
+
+static void
+update (GdkFrameClock            *clock,
+        GtkInspectorFrameMonitor *monitor)
+{
+  end_phase (monitor, PHASE_UPDATE);
+}
+
+static void
+layout (GdkFrameClock            *clock,
+        GtkInspectorFrameMonitor *monitor)
+{
+  end_phase (monitor, PHASE_LAYOUT);
+}
+
+static void
+paint (GdkFrameClock            *clock,
+       GtkInspectorFrameMonitor *monitor)
+{
+  end_phase (monitor, PHASE_PAINT);
+}
+
+static void
+after_paint (GdkFrameClock            *clock,
+             GtkInspectorFrameMonitor *monitor)
+{
+  gint64 refresh_interval;
+
+  /* Started monitoring in the middle of a frame */
+  if (!monitor->in_frame)
+    return;
+
+  gdk_frame_clock_get_refresh_info (clock,
+                                    gdk_frame_clock_get_frame_time (clock),
+                                    &refresh_interval, NULL);
+
+  monitor->current.total = g_get_monotonic_time () - monitor->current.start;
+  monitor->current.refresh_interval = refresh_interval;
+  monitor->in_frame = FALSE;
+
+  monitor->records[monitor->head] = monitor->current;
+  monitor->head = (monitor->head + 1) % monitor->capacity;
+  if (monitor->count < monitor->capacity)
+    monitor->count++;
+  monitor->n_frames++;
+}
+
+GtkInspectorFrameMonitor *
+gtk_inspector_frame_monitor_new (GdkFrameClock *clock,
+                                 guint          capacity)
+{
+  GtkInspectorFrameMonitor *monitor;
+
+  g_return_val_if_fail (capacity > 0, NULL);
+
+  monitor = g_new0 (GtkInspectorFrameMonitor, 1);
+  monitor->clock = (GdkFrameClock *)g_object_ref (clock);
+  monitor->capacity = capacity;
+  monitor->records = g_new0 (FrameRecord, capacity);
+
+  monitor->handlers[HANDLER_FRAME_START] =
+    g_signal_connect (clock, "before-paint", G_CALLBACK (frame_start), monitor);
+  monitor->handlers[HANDLER_BEFORE_PAINT] =
+    g_signal_connect_after (clock, "before-paint", G_CALLBACK (before_paint), monitor);
+  monitor->handlers[HANDLER_UPDATE] =
+    g_signal_connect_after (clock, "update", G_CALLBACK (update), monitor);
+  monitor->handlers[HANDLER_LAYOUT] =
+    g_signal_connect_after (clock, "layout", G_CALLBACK (layout), monitor);
+  monitor->handlers[HANDLER_PAINT] =
+    g_signal_connect_after (clock, "paint", G_CALLBACK (paint), monitor);
+  monitor->handlers[HANDLER_AFTER_PAINT] =
+    g_signal_connect_after (clock, "after-paint", G_CALLBACK (after_paint), monitor);
+
+  return monitor;
+}
+
+void
+gtk_inspector_frame_monitor_free (GtkInspectorFrameMonitor *monitor)
+{
+  guint i;
+
+  for (i = 0; i < N_HANDLERS; i++)
+    g_signal_handler_disconnect (monitor->clock, monitor->handlers[i]);
+  g_object_unref (monitor->clock);
+
+  g_free (monitor->records);
+  g_free (monitor);
+}
+
+void
+gtk_inspector_frame_monitor_reset (GtkInspectorFrameMonitor *monitor)
+{
+  monitor->head = 0;
+  monitor->count = 0;
+  monitor->n_frames = 0;
+  monitor->last_start = 0;
+}
+
+static const FrameRecord *
+get_record (GtkInspectorFrameMonitor *monitor,
+            guint                     n)
+{
+  /* n = 0 is the oldest record kept */
+  return &monitor->records[(monitor->head + monitor->capacity - monitor->count + n) % monitor->capacity];
+}
+
+static guint
+bucket_for (gint32 duration)
+{
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (bucket_limits); i++)
+    if (duration < bucket_limits[i])
+      break;
+
+  return i;
+}
+
+static void
+append_histogram (GString     *report,
+                  const gchar *title,
+                  const guint *buckets)
+{
+  guint i, max = 0;
+
+  g_string_append_printf (report, "%s:\n", title);
+
+  for (i = 0; i < N_BUCKETS; i++)
+    max = MAX (max, buckets[i]);
+
+  for (i = 0; i < N_BUCKETS; i++)
+    {
+      guint width = max > 0 ? (buckets[i] * BAR_WIDTH + max - 1) / max : 0;
+      gchar *bar = g_strnfill (width, '#');
+
+      if (i < G_N_ELEMENTS (bucket_limits))
+        g_string_append_printf (report, "  < %5.1f ms  %-*s %u\n",
+                                bucket_limits[i] / 1000.0, BAR_WIDTH, bar, buckets[i]);
+      else
+        g_string_append_printf (report, "  ≥ %5.1f ms  %-*s %u\n",
+                                bucket_limits[i - 1] / 1000.0, BAR_WIDTH, bar, buckets[i]);
+      g_free (bar);
+    }
+}
+
+gchar *
+gtk_inspector_frame_monitor_report (GtkInspectorFrameMonitor *monitor)
+{
+  guint frame_buckets[N_BUCKETS] = { 0 };
+  guint gap_buckets[N_BUCKETS] = { 0 };
+  gint64 phase_sum[N_PHASES] = { 0 };
+  gint32 phase_max[N_PHASES] = { 0 };
+  GString *report;
+  guint i, p, n_missed, listed;
+
+  report = g_string_new (NULL);
+
+  if (monitor->count == 0)
+    {
+      g_string_append (report, "No frames recorded");
+      return g_string_free (report, FALSE);
+    }
+
+  n_missed = 0;
+  for (i = 0; i < monitor->count; i++)
+    {
+      const FrameRecord *record = get_record (monitor, i);
+
+      frame_buckets[bucket_for (record->total)]++;
+      if (record->gap > 0)
+        gap_buckets[bucket_for (record->gap)]++;
+
+      for (p = 0; p < N_PHASES; p++)
+        {
+          phase_sum[p] += record->phases[p];
+          phase_max[p] = MAX (phase_max[p], record->phases[p]);
+        }
+
+      if (record->total > record->refresh_interval)
+        n_missed++;
+    }
+
+  g_string_append_printf (report, "%" G_GUINT64_FORMAT " frames recorded, last %u kept\n",
+                          monitor->n_frames, monitor->count);
+
+  append_histogram (report, "Frame time", frame_buckets);
+  append_histogram (report, "Time between frames", gap_buckets);
+
+  g_string_append (report, "Phases:\n");
+  for (p = 0; p < N_PHASES; p++)
+    g_string_append_printf (report, "  %-6s  mean %.2f ms, max %.2f ms\n",
+                            phase_names[p],
+                            phase_sum[p] / 1000.0 / monitor->count,
+                            phase_max[p] / 1000.0);
+
+  g_string_append_printf (report, "%u frames missed their deadline", n_missed);
+  if (n_missed > MAX_MISSED_LISTED)
+    g_string_append_printf (report, ", the last %u:", MAX_MISSED_LISTED);
+  else if (n_missed > 0)
+    g_string_append (report, ":");
+
+  /* Most recent first */
+  listed = 0;
+  for (i = monitor->count; i > 0 && listed < MAX_MISSED_LISTED; i--)
+    {
+      const FrameRecord *record = get_record (monitor, i - 1);
+
+      if (record->total <= record->refresh_interval)
+        continue;
+
+      g_string_append_printf (report,
+                              "\n  frame %" G_GINT64_FORMAT ": %.2f ms of %.2f ms"
+                              " (update %.2f, layout %.2f, paint %.2f)",
+                              record->counter,
+                              record->total / 1000.0,
+                              record->refresh_interval / 1000.0,
+                              record->phases[PHASE_UPDATE] / 1000.0,
+                              record->phases[PHASE_LAYOUT] / 1000.0,
+                              record->phases[PHASE_PAINT] / 1000.0);
+      listed++;
+    }
+
+  return g_string_free (report, FALSE);
+}
+
+// vim: set et sw=2 ts=2:
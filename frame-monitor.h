@@ -0,0 +1,48 @@
+/*
+ * Copyright (c) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _GTK_INSPECTOR_FRAME_MONITOR_H_
+#define _GTK_INSPECTOR_FRAME_MONITOR_H_
+
+#include <gdk/gdk.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GtkInspectorFrameMonitor GtkInspectorFrameMonitor;
+
+/* Records the last capacity frames of clock */
+GtkInspectorFrameMonitor *
+gtk_inspector_frame_monitor_new (GdkFrameClock *clock,
+                                 guint          capacity);
+
+void
+gtk_inspector_frame_monitor_free (GtkInspectorFrameMonitor *monitor);
+
+/* Drops the frames recorded so far, and goes on recording */
+void
+gtk_inspector_frame_monitor_reset (GtkInspectorFrameMonitor *monitor);
+
+/* Histograms of the recorded frames and the frames that took longer
+ * than the refresh interval, as text */
+gchar *
+gtk_inspector_frame_monitor_report (GtkInspectorFrameMonitor *monitor);
+
+G_END_DECLS
+
+#endif // _GTK_INSPECTOR_FRAME_MONITOR_H_
+
+// vim: set et sw=2 ts=2:
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "handler-list.h"
+
+/* A finalized object took its handlers with it, so only those whose
+ * object can still be reached are disconnected. */
+
+typedef struct
+{
+  GWeakRef object;
+  gulong   handler;
+} Connection;
+
+struct _GtkInspectorHandlerList
+{
+  GArray *connections;      /* Connection */
+};
+
+GtkInspectorHandlerList *
+gtk_inspector_handler_list_new (void)
+{
+  GtkInspectorHandlerList *list;
+
+  list = g_new0 (GtkInspectorHandlerList, 1);
+  list->connections = g_array_new (FALSE, FALSE, sizeof (Connection));
+
+  return list;
+}
+
+void
+gtk_inspector_handler_list_free (GtkInspectorHandlerList *list)
+{
+  gtk_inspector_handler_list_disconnect_all (list);
+  g_array_unref (list->connections);
+  g_free (list);
+}
+
+void
+gtk_inspector_handler_list_add (GtkInspectorHandlerList *list,
+                                GObject                 *object,
+                                gulong                   handler)
+{
+  Connection connection;
+
+  connection.handler = handler;
+  g_weak_ref_init (&connection.object, object);
+  g_array_append_val (list->connections, connection);
+}
+
+void
+gtk_inspector_handler_list_disconnect_all (GtkInspectorHandlerList *list)
+{
+  guint i;
+
+  for (i = 0; i < list->connections->len; i++)
+    {
+      Connection *connection = &g_array_index (list->connections, Connection, i);
+      GObject *object = (GObject *)g_weak_ref_get (&connection->object);
+
+      if (object)
+        {
+          g_signal_handler_disconnect (object, connection->handler);
+          g_object_unref (object);
+        }
+      g_weak_ref_clear (&connection->object);
+    }
+
+  g_array_set_size (list->connections, 0);
+}
+
+guint
+gtk_inspector_handler_list_get_length (GtkInspectorHandlerList *list)
+{
+  return list->connections->len;
+}
+
+GObject *
+gtk_inspector_handler_list_get_object (GtkInspectorHandlerList *list,
+                                       guint                    i)
+{
+  g_return_val_if_fail (i < list->connections->len, NULL);
+
+  return (GObject *)g_weak_ref_get (&g_array_index (list->connections, Connection, i).object);
+}
+
+// vim: set et sw=2 ts=2:
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _GTK_INSPECTOR_HANDLER_LIST_H_
+#define _GTK_INSPECTOR_HANDLER_LIST_H_
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+/* Signal handlers on objects that may be finalized before they are
+ * disconnected. Each is kept with a weak reference to its object. */
+typedef struct _GtkInspectorHandlerList GtkInspectorHandlerList;
+
+GtkInspectorHandlerList *
+gtk_inspector_handler_list_new (void);
+
+/* Disconnects what is still connected first */
+void
+gtk_inspector_handler_list_free (GtkInspectorHandlerList *list);
+
+void
+gtk_inspector_handler_list_add (GtkInspectorHandlerList *list,
+                                GObject                 *object,
+                                gulong                   handler);
+
+/* Disconnects the handlers whose objects are still alive, and empties
+ * the list */
+void
+gtk_inspector_handler_list_disconnect_all (GtkInspectorHandlerList *list);
+
+guint
+gtk_inspector_handler_list_get_length (GtkInspectorHandlerList *list);
+
+/* Returns a new reference to the object of handler i, in the order
+ * they were added, or NULL if it was finalized */
+GObject *
+gtk_inspector_handler_list_get_object (GtkInspectorHandlerList *list,
+                                       guint                    i);
+
+G_END_DECLS
+
+#endif // _GTK_INSPECTOR_HANDLER_LIST_H_
+
+// vim: set et sw=2 ts=2:
@@ -0,0 +1,511 @@
+/*
+ * Copyright (c) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <glib/gstdio.h>
+
+#include "history.h"
+
+/* The history file is a sequence of NUL-terminated records, only ever
+ * appended to. It is mapped on load, and entries point straight into
+ * the mapping, so loading a large history copies nothing. Duplicates
+ * are resolved on load by keeping the most recent record; the file is
+ * rewritten once it holds more than twice as many records as live
+ * entries. Rewriting replaces the file, so before each append the open
+ * file is checked against the one at the path, and reopened if another
+ * inspector has replaced it. */
+
+typedef struct
+{
+  const gchar *text;
+  guint64      mask;   /* one bit per character class, see char_mask() */
+} HistoryEntry;
+
+struct _GtkInspectorHistory
+{
+  guint        max_length;
+  gchar       *filename;
+  GMappedFile *mapped;
+  int          fd;
+  guint        n_records;
+
+  GArray      *entries;   /* HistoryEntry, oldest first */
+  GHashTable  *lookup;    /* text -> text, for deduplication */
+  GHashTable  *owned;     /* texts added since loading, still in entries */
+  guint        generation;
+};
+
+typedef struct
+{
+  gchar  *query;
+  GArray *matches;        /* indexes into entries, oldest first */
+} SearchLevel;
+
+/* Each keystroke narrows the matches of the previous query rather than
+ * scanning the whole history again; deleting a character pops back to
+ * the matches already computed for the shorter query. */
+struct _GtkInspectorHistorySearch
+{
+  GtkInspectorHistory *history;
+  guint                generation;
+  GPtrArray           *levels;  /* SearchLevel */
+};
+
+#define COMPACT_MIN_RECORDS 1024
+
+static guint64
+char_mask (const gchar *text)
+{
+  guint64 mask = 0;
+  const guchar *p;
+
+  for (p = (const guchar *)text; *p; p++)
+    mask |= G_GUINT64_CONSTANT (1) << (*p % 64);
+
+  return mask;
+}
+
+static void
+history_append_entry (GtkInspectorHistory *history,
+                      const gchar         *text)
+{
+  HistoryEntry entry;
+
+  entry.text = text;
+  entry.mask = char_mask (text);
+  g_array_append_val (history->entries, entry);
+  g_hash_table_insert (history->lookup, (gpointer)text, (gpointer)text);
+}
+
+/* Drops text from lookup, and frees it unless it points into the mapping */
+static void
+history_forget (GtkInspectorHistory *history,
+                const gchar         *text)
+{
+  g_hash_table_remove (history->lookup, text);
+  g_hash_table_remove (history->owned, text);
+}
+
+static void
+history_load (GtkInspectorHistory *history,
+              const gchar         *filename)
+{
+  GError *error = NULL;
+  GPtrArray *records;
+  const gchar *contents, *p, *end;
+  gsize length;
+  gint i;
+
+  history->mapped = g_mapped_file_new (filename, FALSE, &error);
+  if (history->mapped == NULL)
+    {
+      if (!g_error_matches (error, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+        g_warning ("Could not load history: %s", error->message);
+      g_error_free (error);
+      return;
+    }
+
+  contents = g_mapped_file_get_contents (history->mapped);
+  length = g_mapped_file_get_length (history->mapped);
+  end = contents + length;
+
+  records = g_ptr_array_new ();
+  for (p = contents; p < end; )
+    {
+      const gchar *nul = (const gchar *)memchr (p, '\0', end - p);
+
+      /* A record cut short by a crash; dropped below */
+      if (nul == NULL)
+        break;
+
+      if (nul > p)
+        g_ptr_array_add (records, (gpointer)p);
+      p = nul + 1;
+    }
+  history->n_records = records->len;
+
+  /* Drop a partial trailing record so the next append starts clean */
+  if (p < end && history->fd != -1 &&
+      ftruncate (history->fd, p - contents) != 0)
+    g_warning ("Could not truncate history: %s", g_strerror (errno));
+
+  /* Keep the most recent copy of each text, and at most max_length */
+  for (i = records->len - 1; i >= 0; i--)
+    {
+      const gchar *text = (const gchar *)records->pdata[i];
+
+      if (g_hash_table_contains (history->lookup, text))
+        continue;
+      if (history->entries->len == history->max_length)
+        break;
+
+      history_append_entry (history, text);
+    }
+
+  for (i = 0; i < (gint)history->entries->len / 2; i++)
+    {
+      guint j = history->entries->len - 1 - i;
+      HistoryEntry tmp = g_array_index (history->entries, HistoryEntry, i);
+
+      g_array_index (history->entries, HistoryEntry, i) = g_array_index (history->entries, HistoryEntry, j);
+      g_array_index (history->entries, HistoryEntry, j) = tmp;
+    }
+
+  g_ptr_array_unref (records);
+}
+
+static gboolean
+write_all (int          fd,
+           const gchar *data,
+           gsize        length)
+{
+  while (length > 0)
+    {
+      gssize n = write (fd, data, length);
+
+      if (n < 0)
+        {
+          if (errno == EINTR)
+            continue;
+          return FALSE;
+        }
+
+      data += n;
+      length -= n;
+    }
+
+  return TRUE;
+}
+
+static void
+history_compact (GtkInspectorHistory *history,
+                 const gchar         *filename)
+{
+  GString *contents;
+  gchar *tmpname;
+  gboolean ok;
+  guint i;
+  int fd;
+
+  if (history->n_records < COMPACT_MIN_RECORDS ||
+      history->n_records <= 2 * history->entries->len)
+    return;
+
+  contents = g_string_new (NULL);
+  for (i = 0; i < history->entries->len; i++)
+    {
+      const gchar *text = g_array_index (history->entries, HistoryEntry, i).text;
+
+      g_string_append_len (contents, text, strlen (text) + 1);
+    }
+
+  /* The history may hold secrets, so the new file is private from the
+   * start. Entries keep pointing into the old mapping, which stays
+   * valid after the file is replaced. */
+  tmpname = g_strconcat (filename, ".XXXXXX", NULL);
+  fd = g_mkstemp_full (tmpname, O_WRONLY | O_CLOEXEC, 0600);
+  if (fd == -1)
+    {
+      g_warning ("Could not compact history: %s", g_strerror (errno));
+      g_free (tmpname);
+      g_string_free (contents, TRUE);
+      return;
+    }
+
+  ok = write_all (fd, contents->str, contents->len) && fsync (fd) == 0;
+  ok = close (fd) == 0 && ok;
+  ok = ok && g_rename (tmpname, filename) == 0;
+
+  if (ok)
+    {
+      history->n_records = history->entries->len;
+    }
+  else
+    {
+      g_warning ("Could not compact history: %s", g_strerror (errno));
+      g_unlink (tmpname);
+    }
+
+  g_free (tmpname);
+  g_string_free (contents, TRUE);
+}
+
+/* Another inspector compacting the history replaces the file, and
+ * appending to the old one would lose the record */
+static void
+history_reopen_if_replaced (GtkInspectorHistory *history)
+{
+  struct stat open_stat;
+  GStatBuf path_stat;
+
+  if (history->fd == -1)
+    return;
+
+  if (fstat (history->fd, &open_stat) == 0 &&
+      g_stat (history->filename, &path_stat) == 0 &&
+      open_stat.st_dev == path_stat.st_dev &&
+      open_stat.st_ino == path_stat.st_ino)
+    return;
+
+  close (history->fd);
+  history->fd = g_open (history->filename, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0600);
+  if (history->fd == -1)
+    g_warning ("Could not open history file %s: %s", history->filename, g_strerror (errno));
+}
+
+GtkInspectorHistory *
+gtk_inspector_history_new (const gchar *filename,
+                           guint        max_length)
+{
+  GtkInspectorHistory *history;
+  gchar *dirname;
+
+  history = g_new0 (GtkInspectorHistory, 1);
+  history->max_length = max_length;
+  history->entries = g_array_new (FALSE, FALSE, sizeof (HistoryEntry));
+  history->lookup = g_hash_table_new (g_str_hash, g_str_equal);
+  history->owned = g_hash_table_new_full (NULL, NULL, g_free, NULL);
+  history->filename = g_strdup (filename);
+
+  dirname = g_path_get_dirname (filename);
+  g_mkdir_with_parents (dirname, 0700);
+  g_free (dirname);
+
+  history->fd = g_open (filename, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0600);
+  if (history->fd == -1)
+    g_warning ("Could not open history file %s: %s", filename, g_strerror (errno));
+
+  history_load (history, filename);
+  history_compact (history, filename);
+
+  /* The file may have been replaced by compaction */
+  history_reopen_if_replaced (history);
+
+  return history;
+}
+
+void
+gtk_inspector_history_free (GtkInspectorHistory *history)
+{
+  if (history->fd != -1)
+    close (history->fd);
+
+  g_array_unref (history->entries);
+  g_hash_table_unref (history->lookup);
+  g_hash_table_unref (history->owned);
+  if (history->mapped)
+    g_mapped_file_unref (history->mapped);
+
+  g_free (history->filename);
+  g_free (history);
+}
+
+void
+gtk_inspector_history_add (GtkInspectorHistory *history,
+                           const gchar         *text)
+{
+  const gchar *old;
+  gchar *copy;
+  gsize len;
+
+  if (text[0] == 0)
+    return;
+
+  /* text may be an entry that is about to be freed */
+  copy = g_strdup (text);
+
+  old = (const gchar *)g_hash_table_lookup (history->lookup, copy);
+  if (old != NULL)
+    {
+      gint i;
+
+      /* Repeats are usually recent, so look from the end */
+      for (i = history->entries->len - 1; i >= 0; i--)
+        if (g_array_index (history->entries, HistoryEntry, i).text == old)
+          {
+            g_array_remove_index (history->entries, i);
+            break;
+          }
+      history_forget (history, old);
+    }
+
+  g_hash_table_add (history->owned, copy);
+  history_append_entry (history, copy);
+
+  history_reopen_if_replaced (history);
+  if (history->fd != -1)
+    {
+      len = strlen (copy) + 1;
+      if (write (history->fd, copy, len) != (gssize)len)
+        g_warning ("Could not save history: %s", g_strerror (errno));
+      else
+        history->n_records++;
+    }
+
+  if (history->entries->len > history->max_length)
+    {
+      old = g_array_index (history->entries, HistoryEntry, 0).text;
+      g_array_remove_index (history->entries, 0);
+      history_forget (history, old);
+    }
+
+  history->generation++;
+}
+
+guint
+gtk_inspector_history_get_length (GtkInspectorHistory *history)
+{
+  return history->entries->len;
+}
+
+const gchar *
+gtk_inspector_history_get (GtkInspectorHistory *history,
+                           guint                n)
+{
+  if (n >= history->entries->len)
+    return NULL;
+
+  return g_array_index (history->entries, HistoryEntry, history->entries->len - 1 - n).text;
+}
+
+static void
+search_level_free (gpointer data)
+{
+  SearchLevel *level = (SearchLevel *)data;
+
+  g_free (level->query);
+  g_array_unref (level->matches);
+  g_free (level);
+}
+
+GtkInspectorHistorySearch *
+gtk_inspector_history_search_new (GtkInspectorHistory *history)
+{
+  GtkInspectorHistorySearch *search;
+
+  search = g_new0 (GtkInspectorHistorySearch, 1);
+  search->history = history;
+  search->generation = history->generation;
+  search->levels = g_ptr_array_new_with_free_func (search_level_free);
+
+  return search;
+}
+
+void
+gtk_inspector_history_search_free (GtkInspectorHistorySearch *search)
+{
+  g_ptr_array_unref (search->levels);
+  g_free (search);
+}
+
+static GArray *
+search_filter (GtkInspectorHistory *history,
+               GArray              *candidates,
+               const gchar         *query)
+{
+  guint64 mask = char_mask (query);
+  GArray *matches;
+  guint i, n;
+
+  n = candidates ? candidates->len : history->entries->len;
+  matches = g_array_new (FALSE, FALSE, sizeof (guint));
+
+  for (i = 0; i < n; i++)
+    {
+      guint index = candidates ? g_array_index (candidates, guint, i) : i;
+      const HistoryEntry *entry = &g_array_index (history->entries, HistoryEntry, index);
+
+      if ((entry->mask & mask) == mask && strstr (entry->text, query) != NULL)
+        g_array_append_val (matches, index);
+    }
+
+  return matches;
+}
+
+void
+gtk_inspector_history_search_set_query (GtkInspectorHistorySearch *search,
+                                        const gchar               *query)
+{
+  GtkInspectorHistory *history = search->history;
+  SearchLevel *level = NULL;
+  GArray *candidates = NULL;
+
+  if (search->generation != history->generation)
+    {
+      g_ptr_array_set_size (search->levels, 0);
+      search->generation = history->generation;
+    }
+
+  /* Pop levels that the new query doesn't build on */
+  while (search->levels->len > 0)
+    {
+      level = (SearchLevel *)search->levels->pdata[search->levels->len - 1];
+      if (strstr (query, level->query) != NULL)
+        break;
+      g_ptr_array_set_size (search->levels, search->levels->len - 1);
+      level = NULL;
+    }
+
+  if (query[0] == 0 || (level != NULL && strcmp (level->query, query) == 0))
+    return;
+
+  if (level != NULL)
+    candidates = level->matches;
+
+  level = g_new0 (SearchLevel, 1);
+  level->query = g_strdup (query);
+  level->matches = search_filter (history, candidates, query);
+  g_ptr_array_add (search->levels, level);
+}
+
+guint
+gtk_inspector_history_search_get_n_matches (GtkInspectorHistorySearch *search)
+{
+  SearchLevel *level;
+
+  if (search->levels->len == 0)
+    return 0;
+
+  level = (SearchLevel *)search->levels->pdata[search->levels->len - 1];
+  return level->matches->len;
+}
+
+const gchar *
+gtk_inspector_history_search_get_match (GtkInspectorHistorySearch *search,
+                                        guint                      n)
+{
+  GtkInspectorHistory *history = search->history;
+  SearchLevel *level;
+  guint index;
+
+  if (n >= gtk_inspector_history_search_get_n_matches (search))
+    return NULL;
+
+  level = (SearchLevel *)search->levels->pdata[search->levels->len - 1];
+  index = g_array_index (level->matches, guint, level->matches->len - 1 - n);
+
+  return g_array_index (history->entries, HistoryEntry, index).text;
+}
+
+// vim: set et sw=2 ts=2:
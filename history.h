@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _GTK_INSPECTOR_HISTORY_H_
+#define _GTK_INSPECTOR_HISTORY_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GtkInspectorHistory GtkInspectorHistory;
+typedef struct _GtkInspectorHistorySearch GtkInspectorHistorySearch;
+
+GtkInspectorHistory *
+gtk_inspector_history_new (const gchar *filename,
+                           guint        max_length);
+
+void
+gtk_inspector_history_free (GtkInspectorHistory *history);
+
+void
+gtk_inspector_history_add (GtkInspectorHistory *history,
+                           const gchar         *text);
+
+guint
+gtk_inspector_history_get_length (GtkInspectorHistory *history);
+
+/* n counts back from the most recent entry, which is 0 */
+const gchar *
+gtk_inspector_history_get (GtkInspectorHistory *history,
+                           guint                n);
+
+GtkInspectorHistorySearch *
+gtk_inspector_history_search_new (GtkInspectorHistory *history);
+
+void
+gtk_inspector_history_search_free (GtkInspectorHistorySearch *search);
+
+void
+gtk_inspector_history_search_set_query (GtkInspectorHistorySearch *search,
+                                        const gchar               *query);
+
+guint
+gtk_inspector_history_search_get_n_matches (GtkInspectorHistorySearch *search);
+
+/* n counts back from the most recent match, which is 0 */
+const gchar *
+gtk_inspector_history_search_get_match (GtkInspectorHistorySearch *search,
+                                        guint                      n);
+
+G_END_DECLS
+
+#endif // _GTK_INSPECTOR_HISTORY_H_
+
+// vim: set et sw=2 ts=2:
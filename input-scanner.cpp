@@ -0,0 +1,388 @@
+/*
+ * Copyright (c) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "input-scanner.h"
+
+/* Asking the parser whether input is a complete unit means parsing all
+ * of it, so doing that for every line of a long paste is quadratic.
+ * The scanner keeps just enough state to continue where the previous
+ * line left off, and the parser is only asked once nothing is open.
+ *
+ * Whether a '/' starts a regular expression or divides depends on
+ * what came before it: a value (a name, a number, a closing bracket
+ * or a literal) means division, anything else a regular expression,
+ * as do keywords such as return. */
+
+typedef enum {
+  MODE_CODE,
+  MODE_SLASH,           /* a '/' in code, the next character decides */
+  MODE_STRING,
+  MODE_LINE_COMMENT,
+  MODE_BLOCK_COMMENT,
+  MODE_BLOCK_COMMENT_STAR,
+  MODE_REGEX,
+  MODE_REGEX_CLASS
+} ScanMode;
+
+static const gchar *regex_keywords[] = {
+  "return", "typeof", "instanceof", "in", "of", "new", "delete",
+  "void", "throw", "case", "do", "else", "yield"
+};
+
+void
+gtk_inspector_scan_state_init (GtkInspectorScanState *state)
+{
+  memset (state, 0, sizeof (GtkInspectorScanState));
+  state->mode = MODE_CODE;
+  state->regex_allowed = TRUE;
+}
+
+static gboolean
+is_word_char (gchar c)
+{
+  return g_ascii_isalnum (c) || c == '_' || c == '$' || (guchar)c >= 0x80;
+}
+
+static gboolean
+slash_starts_regex (const GtkInspectorScanState *state)
+{
+  guint i;
+
+  if (state->word_len == 0)
+    return state->regex_allowed;
+
+  for (i = 0; i < G_N_ELEMENTS (regex_keywords); i++)
+    if (strlen (regex_keywords[i]) == state->word_len &&
+        strncmp (regex_keywords[i], state->word, state->word_len) == 0)
+      return TRUE;
+
+  return FALSE;
+}
+
+static void
+open_bracket (GtkInspectorScanState *state,
+              gchar                  c)
+{
+  if (state->depth < GTK_INSPECTOR_SCAN_STACK)
+    state->stack[state->depth] = c;
+  state->depth++;
+}
+
+static void
+close_bracket (GtkInspectorScanState *state,
+               gchar                  c)
+{
+  gchar open = c == ')' ? '(' : c == ']' ? '[' : '{';
+
+  if (state->depth == 0)
+    {
+      state->broken = TRUE;
+      return;
+    }
+
+  state->depth--;
+  if (state->depth < GTK_INSPECTOR_SCAN_STACK && state->stack[state->depth] != open)
+    state->broken = TRUE;
+}
+
+static void
+scan_code (GtkInspectorScanState *state,
+           gchar                  c)
+{
+  if (is_word_char (c))
+    {
+      if (!state->in_word)
+        state->word_len = 0;
+      if (state->word_len < GTK_INSPECTOR_SCAN_WORD)
+        state->word[state->word_len] = c;
+      /* Too long for a keyword; still counts as a value */
+      if (state->word_len < G_MAXUINT8)
+        state->word_len++;
+      state->in_word = TRUE;
+      return;
+    }
+
+  state->in_word = FALSE;
+
+  if (g_ascii_isspace (c))
+    return;
+
+  /* Decided by the next character, which may need the last word */
+  if (c == '/')
+    {
+      state->mode = MODE_SLASH;
+      return;
+    }
+
+  state->word_len = 0;
+
+  switch (c)
+    {
+    case '"':
+    case '\'':
+      state->mode = MODE_STRING;
+      state->quote = c;
+      return;
+
+    case '(':
+    case '[':
+    case '{':
+      open_bracket (state, c);
+      state->regex_allowed = TRUE;
+      return;
+
+    case ')':
+    case ']':
+      close_bracket (state, c);
+      state->regex_allowed = FALSE;
+      return;
+
+    case '}':
+      close_bracket (state, c);
+      state->regex_allowed = TRUE;
+      return;
+
+    default:
+      state->regex_allowed = TRUE;
+      return;
+    }
+}
+
+static void
+scan_char (GtkInspectorScanState *state,
+           gchar                  c)
+{
+  switch (state->mode)
+    {
+    case MODE_CODE:
+      scan_code (state, c);
+      break;
+
+    case MODE_SLASH:
+      if (c == '/')
+        {
+          state->mode = MODE_LINE_COMMENT;
+        }
+      else if (c == '*')
+        {
+          state->mode = MODE_BLOCK_COMMENT;
+        }
+      else if (slash_starts_regex (state))
+        {
+          state->mode = MODE_REGEX;
+          state->word_len = 0;
+          scan_char (state, c);
+        }
+      else
+        {
+          state->mode = MODE_CODE;
+          state->word_len = 0;
+          state->regex_allowed = TRUE;
+          scan_char (state, c);
+        }
+      break;
+
+    case MODE_STRING:
+      if (state->escape)
+        state->escape = FALSE;
+      else if (c == '\\')
+        state->escape = TRUE;
+      else if (c == state->quote || c == '\n')
+        {
+          /* An unescaped line break is an error, which the parser
+           * will report; don't let it swallow the rest */
+          state->mode = MODE_CODE;
+          state->regex_allowed = FALSE;
+        }
+      break;
+
+    case MODE_LINE_COMMENT:
+      if (c == '\n')
+        state->mode = MODE_CODE;
+      break;
+
+    case MODE_BLOCK_COMMENT:
+      if (c == '*')
+        state->mode = MODE_BLOCK_COMMENT_STAR;
+      break;
+
+    case MODE_BLOCK_COMMENT_STAR:
+      if (c == '/')
+        state->mode = MODE_CODE;
+      else if (c != '*')
+        state->mode = MODE_BLOCK_COMMENT;
+      break;
+
+    case MODE_REGEX:
+    case MODE_REGEX_CLASS:
+      if (state->escape)
+        state->escape = FALSE;
+      else if (c == '\\')
+        state->escape = TRUE;
+      else if (c == '\n')
+        state->mode = MODE_CODE;
+      else if (state->mode == MODE_REGEX && c == '[')
+        state->mode = MODE_REGEX_CLASS;
+      else if (state->mode == MODE_REGEX_CLASS && c == ']')
+        state->mode = MODE_REGEX;
+      else if (state->mode == MODE_REGEX && c == '/')
+        {
+          state->mode = MODE_CODE;
+          state->regex_allowed = FALSE;
+        }
+      break;
+
+    default:
+      g_assert_not_reached ();
+    }
+}
+
+void
+gtk_inspector_scan (GtkInspectorScanState *state,
+                    const gchar           *text,
+                    gssize                 length)
+{
+  const gchar *p, *end;
+
+  if (length < 0)
+    length = strlen (text);
+
+  end = text + length;
+  for (p = text; p < end; p++)
+    scan_char (state, *p);
+}
+
+gboolean
+gtk_inspector_scan_state_is_complete (const GtkInspectorScanState *state)
+{
+  if (state->mode != MODE_CODE &&
+      state->mode != MODE_SLASH &&
+      state->mode != MODE_LINE_COMMENT)
+    return FALSE;
+
+  return state->depth == 0 || state->broken;
+}
+
+gboolean
+gtk_inspector_scan_state_equal (const GtkInspectorScanState *a,
+                                const GtkInspectorScanState *b)
+{
+  guint n;
+
+  if (a->mode != b->mode ||
+      a->quote != b->quote ||
+      a->escape != b->escape ||
+      a->regex_allowed != b->regex_allowed ||
+      a->broken != b->broken ||
+      a->word_len != b->word_len ||
+      a->in_word != b->in_word ||
+      a->depth != b->depth)
+    return FALSE;
+
+  if (memcmp (a->word, b->word, MIN (a->word_len, GTK_INSPECTOR_SCAN_WORD)) != 0)
+    return FALSE;
+
+  n = MIN (a->depth, GTK_INSPECTOR_SCAN_STACK);
+  return memcmp (a->stack, b->stack, n) == 0;
+}
+
+struct _GtkInspectorScanLines
+{
+  GArray *states;   /* GtkInspectorScanState, at the start of each line and at the end */
+};
+
+GtkInspectorScanLines *
+gtk_inspector_scan_lines_new (void)
+{
+  GtkInspectorScanLines *lines;
+  GtkInspectorScanState state;
+
+  lines = g_new0 (GtkInspectorScanLines, 1);
+  lines->states = g_array_new (FALSE, FALSE, sizeof (GtkInspectorScanState));
+
+  /* One empty line */
+  gtk_inspector_scan_state_init (&state);
+  g_array_append_val (lines->states, state);
+  g_array_append_val (lines->states, state);
+
+  return lines;
+}
+
+void
+gtk_inspector_scan_lines_free (GtkInspectorScanLines *lines)
+{
+  g_array_unref (lines->states);
+  g_free (lines);
+}
+
+void
+gtk_inspector_scan_lines_update (GtkInspectorScanLines    *lines,
+                                 guint                     first,
+                                 guint                     n_removed,
+                                 guint                     n_added,
+                                 GtkInspectorScanLineFunc  get_line,
+                                 gpointer                  data)
+{
+  GtkInspectorScanState state;
+  guint n_lines;
+  guint i;
+
+  g_return_if_fail (first + n_removed < lines->states->len);
+
+  /* Line first keeps its checkpoint; the ones after it shift, and
+   * the new lines get placeholders that are rescanned below */
+  if (n_removed > 1)
+    g_array_remove_range (lines->states, first + 1, n_removed - 1);
+  if (n_added > 1)
+    {
+      gtk_inspector_scan_state_init (&state);
+      for (i = 1; i < n_added; i++)
+        g_array_insert_val (lines->states, first + 1, state);
+    }
+
+  n_lines = lines->states->len - 1;
+  state = g_array_index (lines->states, GtkInspectorScanState, first);
+
+  for (i = first; i < n_lines; i++)
+    {
+      GtkInspectorScanState *old = &g_array_index (lines->states, GtkInspectorScanState, i + 1);
+      gchar *text = get_line (i, data);
+
+      gtk_inspector_scan (&state, text, -1);
+      if (i + 1 < n_lines)
+        gtk_inspector_scan (&state, "\n", 1);
+      g_free (text);
+
+      /* Past the edit and back in step: the rest is as it was */
+      if (i + 1 >= first + n_added && gtk_inspector_scan_state_equal (&state, old))
+        break;
+
+      *old = state;
+    }
+}
+
+const GtkInspectorScanState *
+gtk_inspector_scan_lines_get_end (GtkInspectorScanLines *lines)
+{
+  return &g_array_index (lines->states, GtkInspectorScanState, lines->states->len - 1);
+}
+
+// vim: set et sw=2 ts=2:
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _GTK_INSPECTOR_INPUT_SCANNER_H_
+#define _GTK_INSPECTOR_INPUT_SCANNER_H_
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+#define GTK_INSPECTOR_SCAN_STACK 32
+#define GTK_INSPECTOR_SCAN_WORD  12
+
+/* What is open at some point of JavaScript source: brackets, a
+ * string, a comment or a regular expression. It is plain data, so
+ * it can be copied and kept as a checkpoint. Scanning is a lexical
+ * approximation, meant to tell cheaply when input can't be complete
+ * yet; the parser has the final say once it might be. */
+typedef struct
+{
+  guint8 mode;
+  guint8 quote;
+  guint8 escape;
+  guint8 regex_allowed;
+  guint8 broken;         /* closed something not open, let the parser report it */
+  guint8 word_len;       /* of the last token if it was a word, else 0 */
+  guint8 in_word;
+  gchar  word[GTK_INSPECTOR_SCAN_WORD];
+  guint  depth;
+  gchar  stack[GTK_INSPECTOR_SCAN_STACK];   /* the outermost open brackets */
+} GtkInspectorScanState;
+
+void
+gtk_inspector_scan_state_init (GtkInspectorScanState *state);
+
+void
+gtk_inspector_scan (GtkInspectorScanState *state,
+                    const gchar           *text,
+                    gssize                 length);
+
+/* Whether nothing is left open, so the parser should look */
+gboolean
+gtk_inspector_scan_state_is_complete (const GtkInspectorScanState *state);
+
+gboolean
+gtk_inspector_scan_state_equal (const GtkInspectorScanState *a,
+                                const GtkInspectorScanState *b);
+
+/* The state at the start of every line of a text being edited, so an
+ * edit only rescans from the line it touched until the state at the
+ * start of a line comes out as it was before. */
+typedef struct _GtkInspectorScanLines GtkInspectorScanLines;
+
+/* Returns line n of the text, without its line break */
+typedef gchar * (* GtkInspectorScanLineFunc) (guint    n,
+                                              gpointer data);
+
+GtkInspectorScanLines *
+gtk_inspector_scan_lines_new (void);
+
+void
+gtk_inspector_scan_lines_free (GtkInspectorScanLines *lines);
+
+/* n_removed lines starting at first were replaced by n_added lines */
+void
+gtk_inspector_scan_lines_update (GtkInspectorScanLines    *lines,
+                                 guint                     first,
+                                 guint                     n_removed,
+                                 guint                     n_added,
+                                 GtkInspectorScanLineFunc  get_line,
+                                 gpointer                  data);
+
+const GtkInspectorScanState *
+gtk_inspector_scan_lines_get_end (GtkInspectorScanLines *lines);
+
+G_END_DECLS
+
+#endif // _GTK_INSPECTOR_INPUT_SCANNER_H_
+
+// vim: set et sw=2 ts=2:
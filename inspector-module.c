@@ -1,5 +1,7 @@
 #include <gio/gio.h>
+#include "fake-module.h"
 #include "interactive.h"
+#include "repl-server.h"
 
 void
 g_io_module_load (GIOModule *module)
@@ -22,3 +24,29 @@ g_io_module_query (void)
   return g_strdupv (eps);
 }
 
+
+/* Loaded through GTK_MODULES, with GJS_INSPECTOR_SOCKET set to a path,
+ * the REPL is served on a Unix socket there without the inspector
+ * ever being opened. The page stays alive for the life of the process. */
+G_MODULE_EXPORT void
+gtk_module_init (gint    *argc,
+                 gchar ***argv)
+{
+  const gchar *path = g_getenv ("GJS_INSPECTOR_SOCKET");
+  GtkWidget *interactive;
+  GError *error = NULL;
+
+  if (path == NULL)
+    return;
+
+  g_io_extension_point_register ("gtk-inspector-page");
+  gtk_inspector_interactive_register (gtk_inspector_fake_module_new ());
+
+  interactive = g_object_ref_sink (g_object_new (GTK_TYPE_INSPECTOR_INTERACTIVE, NULL));
+  if (!gtk_inspector_repl_server_start (GTK_INSPECTOR_INTERACTIVE (interactive), path, &error))
+    {
+      g_warning ("Could not serve the REPL on %s: %s", path, error->message);
+      g_error_free (error);
+      g_object_unref (interactive);
+    }
+}
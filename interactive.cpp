@@ -17,19 +17,40 @@
 
 #include "config.h"
 
+#include <string.h>
+#include <time.h>
+
 #include <glib/gi18n-lib.h>
 
 #include <gjs/gjs.h>
 #include <gjs/gjs-module.h>
+#include <gjs/mem.h>
 #include <gi/object.h>
+#include <js/GCAPI.h>
 
 #include "interactive.h"
+#include "completion-index.h"
+#include "history.h"
+#include "frame-monitor.h"
+#include "signal-tracer.h"
+#include "census.h"
+#include "widget-query.h"
+#include "candidate-list.h"
+#include "input-scanner.h"
+#include "watch-list.h"
+#include "notify-monitor.h"
 
 extern "C"
 {
 #include "resources.h"
 }
 
+typedef enum {
+  EVAL_INTERRUPT_NONE,
+  EVAL_INTERRUPT_TIMEOUT,
+  EVAL_INTERRUPT_CANCEL
+} EvalInterrupt;
+
 struct _GtkInspectorInteractivePrivate
 {
   gboolean in_init;
@@ -38,17 +59,118 @@ struct _GtkInspectorInteractivePrivate
   GtkEntry *entry;
   GtkLabel *label;
   GtkLabel *completion_label;
+  GtkScrolledWindow *completion_window;
+  GtkTreeView *completion_view;
+  GtkTreeView *value_view;
+  GtkScrolledWindow *watch_window;
+  GtkTreeView *watch_view;
+  GtkScrolledWindow *editor_window;
+  GtkTextView *editor;
   GjsContext *context;
 
-  GObject *object;
+  /* What this page keeps in the context, see repl.js; rooted until
+   * dispose, since it holds the wrapper of the page */
+  JSObject   *session;
+  gboolean    shared_runtime;
+
+  /* Startup phases, in microseconds */
+  gint64 startup_init;
+  gint64 startup_context;
+  gint64 startup_bootstrap;
+  gint64 startup_warm;
+  guint  warm_id;
 
-  GString *buffer;
+  GObject *object;
 
-  GQueue            *history;
-  GList             *history_current;
+  /* Evaluation results past the retention limit, held weakly */
+  guint       result_retention;
+  GHashTable *weak_results;
+  guint       last_weak_result;
+  guint       weak_results_swept;   /* size after the last sweep */
+
+  /* Lines entered so far of a unit that isn't complete yet, and what
+   * they leave open */
+  GString               *buffer;
+  GtkInspectorScanState  buffer_scan;
+
+  /* What each line of the editor leaves open, and the lines the edit
+   * being made replaces */
+  GtkInspectorScanLines *editor_scan;
+  guint                  edit_first;
+  guint                  edit_removed;
+
+  /* Output waiting to be flushed into the text view */
+  GString *pending_output;
+  guint    flush_id;
+  gboolean disposed;    /* no text view to flush to any more */
+
+  /* Where output goes instead, during gtk_inspector_interactive_eval() */
+  GString *capture;
+
+  /* Ring buffer of the byte lengths of the lines in the text view,
+   * oldest first */
+  guint32 *scrollback;
+  guint    scrollback_capacity;
+  guint    scrollback_head;
+  guint    scrollback_count;
+  guint64  scrollback_bytes;
+  guint    scrollback_lines;
+
+  GtkInspectorHistory *history;
+  gint               history_current;
+
+  /* Incremental reverse search through the history */
+  GtkInspectorHistorySearch *search;
+  guint              search_match;
   gchar             *saved_text;
   int                saved_position;
   gboolean           saved_position_valid;
+
+  /* Evaluation watchdog */
+  guint               eval_timeout;
+  gboolean            evaluating;
+  gint64              eval_start;
+  guint               eval_checks;
+  EvalInterrupt       eval_interrupt;
+  volatile gint       cancel_requested;
+  gchar              *eval_location;
+  JSOperationCallback previous_operation_callback;
+  GThread            *watchdog;
+  GMutex              watchdog_mutex;
+  GCond               watchdog_cond;
+  gboolean            watchdog_quit;
+
+  GtkInspectorFrameMonitor *frame_monitor;
+
+  /* Follows the selected object while running */
+  GtkInspectorNotifyMonitor *notify_monitor;
+
+  /* Named instance censuses, name -> GtkInspectorCensus */
+  GHashTable *census_snapshots;
+
+  /* Completion candidates for the entry text after completion_prefix,
+   * which is NULL when no completion is going on */
+  GtkInspectorCandidateList *candidates;
+  gchar                     *completion_prefix;
+
+  /* Watch expressions, and what __watchResult reported for the one
+   * being evaluated */
+  GtkInspectorWatchList *watches;
+  gchar                 *watch_value;
+  GPtrArray             *watch_objects;
+
+  /* Collections of the REPL runtime, from the GC slice callback.
+   * Times are in microseconds; a cycle's time is the sum of its
+   * slices, not counting the script running in between. */
+  JS::GCSliceCallback previous_gc_callback;
+  guint               gc_cycles;
+  guint               gc_slices;
+  gint64              gc_slice_start;
+  gint64              gc_cycle_time;
+  gint64              gc_last_time;
+  gint64              gc_max_time;
+  gint64              gc_total_time;
+  guint               heap_notify_id;
 };
 
 enum {
@@ -58,6 +180,15 @@ enum {
   PROP_ENTRY,
   PROP_TITLE,
   PROP_USE_PICKER,
+  PROP_EVAL_TIMEOUT,
+  PROP_SCROLLBACK_LINES,
+  PROP_SCROLLBACK_LENGTH,
+  PROP_SCROLLBACK_SIZE,
+  PROP_RESULT_RETENTION,
+  PROP_VALUE_VIEW,
+  PROP_HEAP_SIZE,
+  PROP_GC_COUNT,
+  PROP_SHARED_RUNTIME,
   LAST_PROP
 };
 
@@ -70,26 +201,214 @@ G_DEFINE_DYNAMIC_TYPE_EXTENDED (GtkInspectorInteractive,
                                 G_ADD_PRIVATE_DYNAMIC(GtkInspectorInteractive))
 
 static void error_reporter(JSContext *cx, const char *message, JSErrorReport *report);
+static JSBool operation_callback (JSContext *cx);
+static gpointer watchdog_thread (gpointer data);
+static void editor_insert_text (GtkTextBuffer           *buffer,
+                                GtkTextIter             *location,
+                                gchar                   *text,
+                                gint                     len,
+                                GtkInspectorInteractive *interactive);
+static void editor_inserted_text (GtkTextBuffer           *buffer,
+                                  GtkTextIter             *location,
+                                  gchar                   *text,
+                                  gint                     len,
+                                  GtkInspectorInteractive *interactive);
+static void editor_delete_range (GtkTextBuffer           *buffer,
+                                 GtkTextIter             *start,
+                                 GtkTextIter             *end,
+                                 GtkInspectorInteractive *interactive);
+static void editor_deleted_range (GtkTextBuffer           *buffer,
+                                  GtkTextIter             *start,
+                                  GtkTextIter             *end,
+                                  GtkInspectorInteractive *interactive);
 static JSBool gtk_inspector_interactive_print (JSContext *context,
                                                unsigned   argc,
                                                jsval     *vp);
-
-#define HISTORY_LENGTH 30
+static JSBool gtk_inspector_interactive_use_session (JSContext *context,
+                                                     unsigned   argc,
+                                                     jsval     *vp);
+static JSBool gtk_inspector_interactive_type_members (JSContext *context,
+                                                      unsigned   argc,
+                                                      jsval     *vp);
+static JSBool gtk_inspector_interactive_namespace_members (JSContext *context,
+                                                           unsigned   argc,
+                                                           jsval     *vp);
+static JSBool gtk_inspector_interactive_weak_ref (JSContext *context,
+                                                  unsigned   argc,
+                                                  jsval     *vp);
+static JSBool gtk_inspector_interactive_weak_get (JSContext *context,
+                                                  unsigned   argc,
+                                                  jsval     *vp);
+static JSBool gtk_inspector_interactive_weak_alive (JSContext *context,
+                                                    unsigned   argc,
+                                                    jsval     *vp);
+static JSBool gtk_inspector_interactive_instance_size (JSContext *context,
+                                                       unsigned   argc,
+                                                       jsval     *vp);
+static JSBool gtk_inspector_interactive_startup_report (JSContext *context,
+                                                        unsigned   argc,
+                                                        jsval     *vp);
+static JSBool gtk_inspector_interactive_object_properties (JSContext *context,
+                                                           unsigned   argc,
+                                                           jsval     *vp);
+static JSBool gtk_inspector_interactive_clock (JSContext *context,
+                                               unsigned   argc,
+                                               jsval     *vp);
+static JSBool gtk_inspector_interactive_gc_count (JSContext *context,
+                                                  unsigned   argc,
+                                                  jsval     *vp);
+static JSBool gtk_inspector_interactive_frame_monitor_start (JSContext *context,
+                                                             unsigned   argc,
+                                                             jsval     *vp);
+static JSBool gtk_inspector_interactive_frame_monitor_stop (JSContext *context,
+                                                            unsigned   argc,
+                                                            jsval     *vp);
+static JSBool gtk_inspector_interactive_frame_monitor_reset (JSContext *context,
+                                                             unsigned   argc,
+                                                             jsval     *vp);
+static JSBool gtk_inspector_interactive_frame_monitor_report (JSContext *context,
+                                                              unsigned   argc,
+                                                              jsval     *vp);
+static JSBool gtk_inspector_interactive_notify_monitor_start (JSContext *context,
+                                                              unsigned   argc,
+                                                              jsval     *vp);
+static JSBool gtk_inspector_interactive_notify_monitor_stop (JSContext *context,
+                                                             unsigned   argc,
+                                                             jsval     *vp);
+static JSBool gtk_inspector_interactive_notify_monitor_report (JSContext *context,
+                                                               unsigned   argc,
+                                                               jsval     *vp);
+static JSBool gtk_inspector_interactive_trace_signals (JSContext *context,
+                                                       unsigned   argc,
+                                                       jsval     *vp);
+static JSBool gtk_inspector_interactive_trace_stop (JSContext *context,
+                                                    unsigned   argc,
+                                                    jsval     *vp);
+static JSBool gtk_inspector_interactive_trace_clear (JSContext *context,
+                                                     unsigned   argc,
+                                                     jsval     *vp);
+static JSBool gtk_inspector_interactive_trace_report (JSContext *context,
+                                                      unsigned   argc,
+                                                      jsval     *vp);
+static JSBool gtk_inspector_interactive_census_report (JSContext *context,
+                                                       unsigned   argc,
+                                                       jsval     *vp);
+static JSBool gtk_inspector_interactive_census_snapshot (JSContext *context,
+                                                         unsigned   argc,
+                                                         jsval     *vp);
+static JSBool gtk_inspector_interactive_census_watch (JSContext *context,
+                                                     unsigned   argc,
+                                                     jsval     *vp);
+static JSBool gtk_inspector_interactive_census_diff (JSContext *context,
+                                                     unsigned   argc,
+                                                     jsval     *vp);
+static JSBool gtk_inspector_interactive_query (JSContext *context,
+                                               unsigned   argc,
+                                               jsval     *vp);
+static JSBool gtk_inspector_interactive_heap_stats (JSContext *context,
+                                                    unsigned   argc,
+                                                    jsval     *vp);
+static JSBool gtk_inspector_interactive_gc (JSContext *context,
+                                            unsigned   argc,
+                                            jsval     *vp);
+static JSBool gtk_inspector_interactive_gc_slice (JSContext *context,
+                                                  unsigned   argc,
+                                                  jsval     *vp);
+static JSBool gtk_inspector_interactive_show_completions (JSContext *context,
+                                                          unsigned   argc,
+                                                          jsval     *vp);
+static JSBool gtk_inspector_interactive_hide_completions (JSContext *context,
+                                                          unsigned   argc,
+                                                          jsval     *vp);
+static JSBool gtk_inspector_interactive_watch_add (JSContext *context,
+                                                   unsigned   argc,
+                                                   jsval     *vp);
+static JSBool gtk_inspector_interactive_watch_remove (JSContext *context,
+                                                      unsigned   argc,
+                                                      jsval     *vp);
+static JSBool gtk_inspector_interactive_watch_clear (JSContext *context,
+                                                     unsigned   argc,
+                                                     jsval     *vp);
+static JSBool gtk_inspector_interactive_watch_report (JSContext *context,
+                                                      unsigned   argc,
+                                                      jsval     *vp);
+static JSBool gtk_inspector_interactive_watch_result (JSContext *context,
+                                                      unsigned   argc,
+                                                      jsval     *vp);
+static void watch_evaluate (GtkInspectorWatchList *watches,
+                            guint                  id,
+                            const gchar           *expression,
+                            gpointer               data);
+static void gc_slice_callback (JSRuntime             *runtime,
+                               JS::GCProgress         progress,
+                               const JS::GCDescription &desc);
+static void gc_stats_hand_over (GtkInspectorInteractive *from,
+                                GtkInspectorInteractive *to);
+static gboolean call (GtkInspectorInteractive *interactive,
+                      const char *function,
+                      const char *arg);
+
+#define HISTORY_LENGTH 100000
+
+/* How often a running evaluation is interrupted to check its time
+ * budget and whether Escape asked to cancel it */
+#define WATCHDOG_TICK_MS 100
+#define DEFAULT_EVAL_TIMEOUT 10000
+
+/* Lines kept in the output view by default. Once the view holds a
+ * quarter more than the limit, the excess is removed in one go. */
+#define DEFAULT_SCROLLBACK_LINES 10000
+#define SCROLLBACK_MIN_CAPACITY 64
+
+/* Frames the frame monitor keeps by default */
+#define DEFAULT_FRAME_MONITOR_CAPACITY 1000
+
+/* Properties the notify monitor counts separately by default */
+#define DEFAULT_NOTIFY_MONITOR_CAPACITY 256
+
+/* The GC slice callback has no user data; this maps the runtime of
+ * each page's context back to the page */
+static GHashTable *gc_runtimes;
+
+/* Pages with shared-runtime set, as they all are when
+ * GJS_INSPECTOR_SHARED_RUNTIME is, share one context, so the engine
+ * runtime, the standard classes and the import caches are paid for
+ * once rather than per page. A gjs context has a single
+ * global, so what each page keeps for itself (its results, scope and
+ * __inspector) lives in a session object that is swapped in before
+ * the page runs anything, and the context's "interactive" data points
+ * at that page so output goes there. Code that runs later on its own,
+ * such as a signal handler, reports to the page that ran last. */
+static GjsContext *shared_context;
+static GList      *shared_pages;
+
+/* Results r(n) keeps strongly before holding them weakly */
+#define DEFAULT_RESULT_RETENTION 100
 
 enum {
   COMPLETE,
   MOVE_HISTORY,
+  CANCEL,
+  SEARCH_HISTORY,
+  EDIT_BUFFER,
+  RUN_BUFFER,
   LAST_SIGNAL
 };
 
 static guint signals[LAST_SIGNAL] = { 0 };
 
-/* This lists a bunch of imports in order to initialize these, as they seem
-   to show a bunch of warning during initialization which we want to avoid */
+/* What the first prompt needs; the scope imports its modules lazily */
 static const char *init_js_code =
   "window.__complete = imports.inspector.repl.complete;\n"
   "window.__eval = imports.inspector.repl.evalLine;\n"
   "window.__objectChanged = imports.inspector.repl.objectChanged;\n"
+  "window.__newSession = imports.inspector.repl.createSession;\n"
+  "window.__watchEval = imports.inspector.repl.watchEval;\n";
+
+/* This lists a bunch of imports in order to initialize these, as they seem
+   to show a bunch of warning during initialization which we want to avoid.
+   It runs at idle once the prompt is usable. */
+static const char *warm_js_code =
   "imports.gi.Gio;\n"
   "imports.gi.Pango;\n"
   "imports.cairo;\n"
@@ -97,63 +416,373 @@ static const char *init_js_code =
 
 static JSFunctionSpec global_funcs[] = {
     { "print", JSOP_WRAPPER (gtk_inspector_interactive_print), 0, GJS_MODULE_PROP_FLAGS },
+    { "__useSession", JSOP_WRAPPER (gtk_inspector_interactive_use_session), 1, GJS_MODULE_PROP_FLAGS },
+    { "__typeMembers", JSOP_WRAPPER (gtk_inspector_interactive_type_members), 3, GJS_MODULE_PROP_FLAGS },
+    { "__namespaceMembers", JSOP_WRAPPER (gtk_inspector_interactive_namespace_members), 2, GJS_MODULE_PROP_FLAGS },
+    { "__weakRef", JSOP_WRAPPER (gtk_inspector_interactive_weak_ref), 1, GJS_MODULE_PROP_FLAGS },
+    { "__weakGet", JSOP_WRAPPER (gtk_inspector_interactive_weak_get), 1, GJS_MODULE_PROP_FLAGS },
+    { "__weakAlive", JSOP_WRAPPER (gtk_inspector_interactive_weak_alive), 1, GJS_MODULE_PROP_FLAGS },
+    { "__instanceSize", JSOP_WRAPPER (gtk_inspector_interactive_instance_size), 1, GJS_MODULE_PROP_FLAGS },
+    { "__startupReport", JSOP_WRAPPER (gtk_inspector_interactive_startup_report), 0, GJS_MODULE_PROP_FLAGS },
+    { "__objectProperties", JSOP_WRAPPER (gtk_inspector_interactive_object_properties), 1, GJS_MODULE_PROP_FLAGS },
+    { "__clock", JSOP_WRAPPER (gtk_inspector_interactive_clock), 0, GJS_MODULE_PROP_FLAGS },
+    { "__gcCount", JSOP_WRAPPER (gtk_inspector_interactive_gc_count), 0, GJS_MODULE_PROP_FLAGS },
+    { "__frameMonitorStart", JSOP_WRAPPER (gtk_inspector_interactive_frame_monitor_start), 2, GJS_MODULE_PROP_FLAGS },
+    { "__frameMonitorStop", JSOP_WRAPPER (gtk_inspector_interactive_frame_monitor_stop), 0, GJS_MODULE_PROP_FLAGS },
+    { "__frameMonitorReset", JSOP_WRAPPER (gtk_inspector_interactive_frame_monitor_reset), 0, GJS_MODULE_PROP_FLAGS },
+    { "__frameMonitorReport", JSOP_WRAPPER (gtk_inspector_interactive_frame_monitor_report), 0, GJS_MODULE_PROP_FLAGS },
+    { "__notifyMonitorStart", JSOP_WRAPPER (gtk_inspector_interactive_notify_monitor_start), 2, GJS_MODULE_PROP_FLAGS },
+    { "__notifyMonitorStop", JSOP_WRAPPER (gtk_inspector_interactive_notify_monitor_stop), 0, GJS_MODULE_PROP_FLAGS },
+    { "__notifyMonitorReport", JSOP_WRAPPER (gtk_inspector_interactive_notify_monitor_report), 1, GJS_MODULE_PROP_FLAGS },
+    { "__traceSignals", JSOP_WRAPPER (gtk_inspector_interactive_trace_signals), 2, GJS_MODULE_PROP_FLAGS },
+    { "__traceStop", JSOP_WRAPPER (gtk_inspector_interactive_trace_stop), 0, GJS_MODULE_PROP_FLAGS },
+    { "__traceClear", JSOP_WRAPPER (gtk_inspector_interactive_trace_clear), 0, GJS_MODULE_PROP_FLAGS },
+    { "__traceReport", JSOP_WRAPPER (gtk_inspector_interactive_trace_report), 1, GJS_MODULE_PROP_FLAGS },
+    { "__censusReport", JSOP_WRAPPER (gtk_inspector_interactive_census_report), 1, GJS_MODULE_PROP_FLAGS },
+    { "__censusSnapshot", JSOP_WRAPPER (gtk_inspector_interactive_census_snapshot), 1, GJS_MODULE_PROP_FLAGS },
+    { "__censusDiff", JSOP_WRAPPER (gtk_inspector_interactive_census_diff), 3, GJS_MODULE_PROP_FLAGS },
+    { "__censusWatch", JSOP_WRAPPER (gtk_inspector_interactive_census_watch), 1, GJS_MODULE_PROP_FLAGS },
+    { "__query", JSOP_WRAPPER (gtk_inspector_interactive_query), 2, GJS_MODULE_PROP_FLAGS },
+    { "__heapStats", JSOP_WRAPPER (gtk_inspector_interactive_heap_stats), 0, GJS_MODULE_PROP_FLAGS },
+    { "__gc", JSOP_WRAPPER (gtk_inspector_interactive_gc), 0, GJS_MODULE_PROP_FLAGS },
+    { "__gcSlice", JSOP_WRAPPER (gtk_inspector_interactive_gc_slice), 1, GJS_MODULE_PROP_FLAGS },
+    { "__showCompletions", JSOP_WRAPPER (gtk_inspector_interactive_show_completions), 2, GJS_MODULE_PROP_FLAGS },
+    { "__hideCompletions", JSOP_WRAPPER (gtk_inspector_interactive_hide_completions), 0, GJS_MODULE_PROP_FLAGS },
+    { "__watchAdd", JSOP_WRAPPER (gtk_inspector_interactive_watch_add), 1, GJS_MODULE_PROP_FLAGS },
+    { "__watchRemove", JSOP_WRAPPER (gtk_inspector_interactive_watch_remove), 1, GJS_MODULE_PROP_FLAGS },
+    { "__watchClear", JSOP_WRAPPER (gtk_inspector_interactive_watch_clear), 0, GJS_MODULE_PROP_FLAGS },
+    { "__watchReport", JSOP_WRAPPER (gtk_inspector_interactive_watch_report), 0, GJS_MODULE_PROP_FLAGS },
+    { "__watchResult", JSOP_WRAPPER (gtk_inspector_interactive_watch_result), 2, GJS_MODULE_PROP_FLAGS },
     { NULL },
 };
 
 static void
-gtk_inspector_interactive_init (GtkInspectorInteractive *interactive)
+free_weak_result (gpointer data)
+{
+  g_weak_ref_clear ((GWeakRef *)data);
+  g_free (data);
+}
+
+/* Runs context in the current thread's current GjsContext slot, so
+ * that the one of the inspected application is left alone */
+static GjsContext *
+push_context (GjsContext *context)
+{
+  GjsContext *old_current;
+
+  old_current = gjs_context_get_current ();
+  if (old_current != context)
+    {
+      gjs_context_make_current (NULL);
+      if (context)
+        gjs_context_make_current (context);
+    }
+
+  return old_current;
+}
+
+static void
+pop_context (GjsContext *context,
+             GjsContext *old_current)
+{
+  if (old_current != context)
+    {
+      gjs_context_make_current (NULL);
+      if (old_current)
+        gjs_context_make_current (old_current);
+    }
+}
+
+/* Makes interactive's session the current one in its context */
+static void
+swap_in_session (GtkInspectorInteractive *interactive)
+{
+  JSContext *context;
+  JSObject *global;
+  jsval session, inspector;
+
+  context = (JSContext *)gjs_context_get_native_context (interactive->priv->context);
+  global = gjs_get_global_object (context);
+
+  JSAutoCompartment ac(context, global);
+  JSAutoRequest ar(context);
+
+  g_object_set_data (G_OBJECT (interactive->priv->context), "interactive", interactive);
+
+  session.setObject (*interactive->priv->session);
+  if (!JS_GetProperty (context, interactive->priv->session, "inspector", &inspector) ||
+      !JS_SetProperty (context, global, "__session", &session) ||
+      !JS_SetProperty (context, global, "__inspector", &inspector))
+    g_error ("Failed to switch sessions");
+}
+
+static void
+use_session (GtkInspectorInteractive *interactive)
+{
+  if (g_object_get_data (G_OBJECT (interactive->priv->context), "interactive") != interactive)
+    swap_in_session (interactive);
+}
+
+static gboolean
+warm_imports (gpointer data)
+{
+  GtkInspectorInteractive *interactive = GTK_INSPECTOR_INTERACTIVE (data);
+  GjsContext *old_current;
+  gint64 start;
+
+  interactive->priv->warm_id = 0;
+
+  start = g_get_monotonic_time ();
+  old_current = push_context (interactive->priv->context);
+  use_session (interactive);
+
+  interactive->priv->in_init = TRUE;
+  gjs_context_eval (interactive->priv->context,
+                    warm_js_code, -1, "<init>",
+                    NULL, NULL);
+  interactive->priv->in_init = FALSE;
+
+  pop_context (interactive->priv->context, old_current);
+  interactive->priv->startup_warm = g_get_monotonic_time () - start;
+
+  return G_SOURCE_REMOVE;
+}
+
+/* The JS context is only created once the page is focused or used,
+ * since most inspector sessions never open the Interactive page */
+static void
+ensure_context (GtkInspectorInteractive *interactive)
 {
   JSContext *context;
   JSObject *global;
   const char *search_path[] = { "resource:///org/gnome/gjs-inspector/js", NULL };
   GjsContext *old_current;
+  gint64 start, created;
+  gboolean shared, joined;
+
+  if (interactive->priv->context != NULL)
+    return;
+
+  shared = interactive->priv->shared_runtime;
+  joined = shared && shared_context != NULL;
+
+  start = g_get_monotonic_time ();
+  old_current = push_context (NULL);
+
+  if (joined)
+    {
+      GtkInspectorInteractivePrivate *first = GTK_INSPECTOR_INTERACTIVE (shared_pages->data)->priv;
+
+      /* The runtime is set up already, chain up to what it had before */
+      interactive->priv->context = (GjsContext *)g_object_ref (shared_context);
+      interactive->priv->previous_operation_callback = first->previous_operation_callback;
+      interactive->priv->previous_gc_callback = first->previous_gc_callback;
+    }
+  else
+    {
+      interactive->priv->context = (GjsContext *)g_object_new (GJS_TYPE_CONTEXT,
+                                                               "search-path", search_path,
+                                                               NULL);
+      if (shared)
+        shared_context = interactive->priv->context;
+    }
+  if (shared)
+    shared_pages = g_list_append (shared_pages, interactive);
+
+  g_object_set_data (G_OBJECT (interactive->priv->context), "interactive", interactive);
+  context = (JSContext *)gjs_context_get_native_context (interactive->priv->context);
+  global = gjs_get_global_object (context);
+
+  if (!joined)
+    {
+      JS_SetErrorReporter (context, error_reporter);
+      interactive->priv->previous_operation_callback = JS_SetOperationCallback (context, operation_callback);
+      if (gc_runtimes == NULL)
+        gc_runtimes = g_hash_table_new (NULL, NULL);
+      g_hash_table_insert (gc_runtimes, JS_GetRuntime (context), interactive);
+      interactive->priv->previous_gc_callback = JS::SetGCSliceCallback (JS_GetRuntime (context), gc_slice_callback);
+    }
+  interactive->priv->watchdog = g_thread_new ("interactive-watchdog", watchdog_thread, interactive);
+
+  created = g_get_monotonic_time ();
+
+  {
+    JSAutoCompartment ac(context, global);
+    JSAutoRequest ar(context);
+    jsval func, inspector, session;
+
+    interactive->priv->in_init = TRUE;
+
+    if (!joined)
+      {
+        if (!JS_DefineFunctions(context, global, &global_funcs[0]))
+          g_error("Failed to define properties on the global object");
+
+        gjs_context_eval (interactive->priv->context,
+                          init_js_code, -1, "<init>",
+                          NULL, NULL);
+      }
+
+    inspector.setObject(*gjs_object_from_g_object (context, G_OBJECT (interactive)));
+
+    if (!JS_GetProperty (context, global, "__newSession", &func) ||
+        !JS_CallFunctionValue (context, NULL, func, 1, &inspector, &session) ||
+        JSVAL_IS_PRIMITIVE (session))
+      g_error ("Failed to create a session");
+
+    interactive->priv->session = JSVAL_TO_OBJECT (session);
+    JS_AddNamedObjectRoot (context, &interactive->priv->session, "interactive session");
+
+    interactive->priv->in_init = FALSE;
+  }
+
+  swap_in_session (interactive);
+
+  pop_context (NULL, old_current);
+
+  interactive->priv->startup_context = created - start;
+  interactive->priv->startup_bootstrap = g_get_monotonic_time () - created;
+  if (!joined)
+    interactive->priv->warm_id = g_idle_add (warm_imports, interactive);
+
+  if (interactive->priv->object)
+    call (interactive, "__objectChanged", NULL);
+}
+
+static void
+gtk_inspector_interactive_init (GtkInspectorInteractive *interactive)
+{
+  GtkTextBuffer *text_buffer;
+  gchar *history_file;
+  gint64 start;
+
+  start = g_get_monotonic_time ();
 
   interactive->priv = (GtkInspectorInteractivePrivate*)gtk_inspector_interactive_get_instance_private (interactive);
   gtk_widget_init_template (GTK_WIDGET (interactive));
-  interactive->priv->history = g_queue_new ();
+  history_file = g_build_filename (g_get_user_data_dir (), "gjs-inspector", "history", NULL);
+  interactive->priv->history = gtk_inspector_history_new (history_file, HISTORY_LENGTH);
+  interactive->priv->history_current = -1;
+  g_free (history_file);
 
   interactive->priv->buffer = g_string_new ("");
+  gtk_inspector_scan_state_init (&interactive->priv->buffer_scan);
+  interactive->priv->editor_scan = gtk_inspector_scan_lines_new ();
+  interactive->priv->pending_output = g_string_new ("");
+  interactive->priv->eval_timeout = DEFAULT_EVAL_TIMEOUT;
+  interactive->priv->scrollback_lines = DEFAULT_SCROLLBACK_LINES;
+  interactive->priv->result_retention = DEFAULT_RESULT_RETENTION;
+  interactive->priv->weak_results = g_hash_table_new_full (NULL, NULL, NULL, free_weak_result);
+  interactive->priv->census_snapshots = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                                               (GDestroyNotify)gtk_inspector_census_free);
+  g_mutex_init (&interactive->priv->watchdog_mutex);
+  g_cond_init (&interactive->priv->watchdog_cond);
 
   gtk_label_set_lines (interactive->priv->completion_label, 7);
 
-  old_current = gjs_context_get_current ();
-  if (old_current)
-    gjs_context_make_current (NULL);
+  text_buffer = gtk_text_view_get_buffer (interactive->priv->editor);
+  g_signal_connect (text_buffer, "insert-text", G_CALLBACK (editor_insert_text), interactive);
+  g_signal_connect_after (text_buffer, "insert-text", G_CALLBACK (editor_inserted_text), interactive);
+  g_signal_connect (text_buffer, "delete-range", G_CALLBACK (editor_delete_range), interactive);
+  g_signal_connect_after (text_buffer, "delete-range", G_CALLBACK (editor_deleted_range), interactive);
+  interactive->priv->candidates = gtk_inspector_candidate_list_new ();
+  interactive->priv->watches = gtk_inspector_watch_list_new (GTK_WIDGET (interactive),
+                                                             GTK_LIST_STORE (gtk_tree_view_get_model (interactive->priv->watch_view)),
+                                                             watch_evaluate, interactive);
+
+  interactive->priv->startup_init = g_get_monotonic_time () - start;
+}
 
-  interactive->priv->context = (GjsContext *)g_object_new (GJS_TYPE_CONTEXT,
-                                                           "search-path", search_path,
-                                                           NULL);
-  g_object_set_data (G_OBJECT (interactive->priv->context), "interactive", interactive);
-  JS_SetErrorReporter ((JSContext *)gjs_context_get_native_context (interactive->priv->context), error_reporter);
+static gboolean
+collect_context (gpointer data)
+{
+  gjs_context_gc (GJS_CONTEXT (data));
 
-  context = (JSContext *)gjs_context_get_native_context (interactive->priv->context);
-  global = gjs_get_global_object (context);
+  return G_SOURCE_REMOVE;
+}
 
-  JSAutoCompartment ac(context, global);
-  JSAutoRequest ar(context);
-  jsval inspector;
+static gboolean
+release_context (gpointer data)
+{
+  g_object_unref (data);
 
-  interactive->priv->in_init = TRUE;
+  return G_SOURCE_REMOVE;
+}
 
-  if (!JS_DefineFunctions(context, global, &global_funcs[0]))
-    g_error("Failed to define properties on the global object");
+/* Unroots the session and lets the context go on without the page. The
+ * session and the global hold the wrapper of the page, whose toggle
+ * reference keeps the page alive; once neither does, the next GC
+ * drops the wrapper, and with it the last reference. */
+static void
+leave_context (GtkInspectorInteractive *interactive)
+{
+  GtkInspectorInteractivePrivate *priv = interactive->priv;
+  JSContext *context = (JSContext *)gjs_context_get_native_context (priv->context);
+  JSObject *global = gjs_get_global_object (context);
+  JSRuntime *runtime = JS_GetRuntime (context);
+  gboolean current = g_object_get_data (G_OBJECT (priv->context), "interactive") == interactive;
 
-  inspector.setObject(*gjs_object_from_g_object (context, G_OBJECT (interactive)));
+  {
+    JSAutoCompartment ac(context, global);
+    JSAutoRequest ar(context);
 
-  gjs_context_eval (interactive->priv->context,
-                    init_js_code, -1, "<init>",
-                    NULL, NULL);
+    JS_RemoveObjectRoot (context, &priv->session);
+    priv->session = NULL;
 
-  if (!JS_SetProperty(context, global, "__inspector", &inspector))
-    g_error("Failed to define properties on the global object");
+    if (current)
+      {
+        jsval undefined = JSVAL_VOID;
 
-  interactive->priv->in_init = FALSE;
+        if (!JS_SetProperty (context, global, "__session", &undefined) ||
+            !JS_SetProperty (context, global, "__inspector", &undefined))
+          g_error ("Failed to switch sessions");
+      }
+  }
 
-  if (old_current != NULL)
+  shared_pages = g_list_remove (shared_pages, interactive);
+  if (priv->context == shared_context && shared_pages != NULL)
     {
-      gjs_context_make_current (NULL);
-      gjs_context_make_current (old_current);
+      GtkInspectorInteractive *next = GTK_INSPECTOR_INTERACTIVE (shared_pages->data);
+
+      if (g_hash_table_lookup (gc_runtimes, runtime) == interactive)
+        gc_stats_hand_over (interactive, next);
+      if (current)
+        swap_in_session (next);
+    }
+  else
+    {
+      JS::SetGCSliceCallback (runtime, priv->previous_gc_callback);
+      g_hash_table_remove (gc_runtimes, runtime);
+      if (priv->context == shared_context)
+        shared_context = NULL;
+    }
+
+  /* After whoever holds the page now has let go of it */
+  g_idle_add_full (G_PRIORITY_DEFAULT_IDLE, collect_context,
+                   g_object_ref (priv->context), g_object_unref);
+}
+
+/* The flush writes to the text view, which is gone after dispose */
+static void
+gtk_inspector_interactive_dispose (GObject *object)
+{
+  GtkInspectorInteractive *interactive = GTK_INSPECTOR_INTERACTIVE (object);
+
+  interactive->priv->disposed = TRUE;
+  if (interactive->priv->flush_id)
+    {
+      g_source_remove (interactive->priv->flush_id);
+      interactive->priv->flush_id = 0;
+    }
+  if (interactive->priv->warm_id)
+    {
+      g_source_remove (interactive->priv->warm_id);
+      interactive->priv->warm_id = 0;
     }
+  if (interactive->priv->session)
+    leave_context (interactive);
+
+  G_OBJECT_CLASS (gtk_inspector_interactive_parent_class)->dispose (object);
 }
 
 static void
@@ -161,10 +790,43 @@ gtk_inspector_interactive_finalize (GObject *object)
 {
   GtkInspectorInteractive *interactive = GTK_INSPECTOR_INTERACTIVE (object);
 
+  if (interactive->priv->watchdog)
+    {
+      g_mutex_lock (&interactive->priv->watchdog_mutex);
+      interactive->priv->watchdog_quit = TRUE;
+      g_cond_signal (&interactive->priv->watchdog_cond);
+      g_mutex_unlock (&interactive->priv->watchdog_mutex);
+      g_thread_join (interactive->priv->watchdog);
+    }
+  g_mutex_clear (&interactive->priv->watchdog_mutex);
+  g_cond_clear (&interactive->priv->watchdog_cond);
+
+  /* Still current in the context if it was alone in it */
+  if (interactive->priv->context &&
+      g_object_get_data (G_OBJECT (interactive->priv->context), "interactive") == interactive)
+    g_object_set_data (G_OBJECT (interactive->priv->context), "interactive", NULL);
+  if (interactive->priv->heap_notify_id)
+    g_source_remove (interactive->priv->heap_notify_id);
+
   g_clear_object (&interactive->priv->object);
-  g_clear_object (&interactive->priv->context);
+  g_hash_table_unref (interactive->priv->weak_results);
+  g_hash_table_unref (interactive->priv->census_snapshots);
+  g_clear_object (&interactive->priv->candidates);
+  gtk_inspector_watch_list_free (interactive->priv->watches);
+  g_free (interactive->priv->completion_prefix);
+  /* This can run from the finalizer of our wrapper, in the middle of
+   * a GC of the context's own runtime */
+  if (interactive->priv->context)
+    g_idle_add (release_context, interactive->priv->context);
   g_clear_pointer (&interactive->priv->saved_text, g_free);
-  g_queue_free_full (interactive->priv->history, g_free);
+  g_clear_pointer (&interactive->priv->eval_location, g_free);
+  g_string_free (interactive->priv->pending_output, TRUE);
+  g_free (interactive->priv->scrollback);
+  g_clear_pointer (&interactive->priv->search, gtk_inspector_history_search_free);
+  gtk_inspector_history_free (interactive->priv->history);
+  gtk_inspector_scan_lines_free (interactive->priv->editor_scan);
+  g_clear_pointer (&interactive->priv->frame_monitor, gtk_inspector_frame_monitor_free);
+  g_clear_pointer (&interactive->priv->notify_monitor, gtk_inspector_notify_monitor_free);
 
   G_OBJECT_CLASS (gtk_inspector_interactive_parent_class)->finalize (object);
 }
@@ -174,27 +836,194 @@ static void
 gtk_inspector_interactive_constructed (GObject *object)
 {
   G_OBJECT_CLASS (gtk_inspector_interactive_parent_class)->constructed (object);
+
+  gtk_inspector_completion_warm_namespaces ();
 }
 
 static void
-gtk_inspector_interactive_add_line (GtkInspectorInteractive *interactive,
-                                    const char *str)
+scrollback_resize (GtkInspectorInteractivePrivate *priv,
+                   guint                           capacity)
+{
+  guint32 *lines;
+  guint i;
+
+  capacity = MAX (capacity, MAX (priv->scrollback_count, SCROLLBACK_MIN_CAPACITY));
+
+  lines = g_new (guint32, capacity);
+  for (i = 0; i < priv->scrollback_count; i++)
+    lines[i] = priv->scrollback[(priv->scrollback_head + i) % priv->scrollback_capacity];
+
+  g_free (priv->scrollback);
+  priv->scrollback = lines;
+  priv->scrollback_capacity = capacity;
+  priv->scrollback_head = 0;
+}
+
+static void
+scrollback_push (GtkInspectorInteractivePrivate *priv,
+                 guint32                         length)
 {
+  guint tail;
+
+  if (priv->scrollback_count == priv->scrollback_capacity)
+    scrollback_resize (priv, priv->scrollback_capacity * 2);
+
+  tail = (priv->scrollback_head + priv->scrollback_count) % priv->scrollback_capacity;
+  priv->scrollback[tail] = length;
+  priv->scrollback_count++;
+  priv->scrollback_bytes += length;
+}
+
+/* Drops the oldest n_lines lines from the ring and the text view */
+static void
+scrollback_trim (GtkInspectorInteractive *interactive,
+                 guint                    n_lines)
+{
+  GtkInspectorInteractivePrivate *priv = interactive->priv;
+  GtkTextBuffer *buffer;
+  GtkTextIter start, end;
+  guint i;
+
+  n_lines = MIN (n_lines, priv->scrollback_count);
+  if (n_lines == 0)
+    return;
+
+  for (i = 0; i < n_lines; i++)
+    {
+      priv->scrollback_bytes -= priv->scrollback[priv->scrollback_head];
+      priv->scrollback_head = (priv->scrollback_head + 1) % priv->scrollback_capacity;
+    }
+  priv->scrollback_count -= n_lines;
+
+  buffer = gtk_text_view_get_buffer (priv->textview);
+  gtk_text_buffer_get_start_iter (buffer, &start);
+  gtk_text_buffer_get_iter_at_line (buffer, &end, n_lines);
+  gtk_text_buffer_delete (buffer, &start, &end);
+}
+
+static void
+scrollback_set_limit (GtkInspectorInteractive *interactive,
+                      guint                    n_lines)
+{
+  GtkInspectorInteractivePrivate *priv = interactive->priv;
+
+  priv->scrollback_lines = n_lines;
+
+  if (n_lines > 0 && priv->scrollback_count > n_lines)
+    {
+      scrollback_trim (interactive, priv->scrollback_count - n_lines);
+      scrollback_resize (priv, n_lines + n_lines / 4);
+      g_object_notify_by_pspec (G_OBJECT (interactive), param_specs[PROP_SCROLLBACK_LENGTH]);
+      g_object_notify_by_pspec (G_OBJECT (interactive), param_specs[PROP_SCROLLBACK_SIZE]);
+    }
+}
+
+/* Returns where the line starting at p ends, including its break. Lines
+ * are broken where GtkTextBuffer breaks them: at \n, \r, \r\n and
+ * U+2029. Pending output always ends with a break. */
+static const char *
+next_line (const char *p,
+           const char *end)
+{
+  gint delimiter, next;
+
+  pango_find_paragraph_boundary (p, end - p, &delimiter, &next);
+
+  return p + next;
+}
+
+static gboolean
+flush_output (gpointer data)
+{
+  GtkInspectorInteractive *interactive = GTK_INSPECTOR_INTERACTIVE (data);
+  GtkInspectorInteractivePrivate *priv = interactive->priv;
   GtkTextBuffer *buffer;
   GtkTextIter iter;
   GtkTextMark *insert_mark;
+  const char *text, *end, *p;
+  guint n_lines;
 
-  buffer = gtk_text_view_get_buffer (interactive->priv->textview);
-  gtk_text_buffer_get_end_iter (buffer, &iter);
-  gtk_text_buffer_insert (buffer, &iter, str, -1);
+  priv->flush_id = 0;
+
+  text = priv->pending_output->str;
+  end = text + priv->pending_output->len;
+
+  /* Don't insert lines that would be trimmed right away */
+  n_lines = 0;
+  for (p = text; p < end; p = next_line (p, end))
+    n_lines++;
+
+  for (; priv->scrollback_lines > 0 && n_lines > priv->scrollback_lines; n_lines--)
+    text = next_line (text, end);
+
+  buffer = gtk_text_view_get_buffer (priv->textview);
   gtk_text_buffer_get_end_iter (buffer, &iter);
-  gtk_text_buffer_insert (buffer, &iter, "\n", -1);
+  gtk_text_buffer_insert (buffer, &iter, text, end - text);
+
+  for (p = text; p < end; )
+    {
+      const char *eol = next_line (p, end);
+
+      scrollback_push (priv, eol - p);
+      p = eol;
+    }
+
+  g_string_set_size (priv->pending_output, 0);
+
+  if (priv->scrollback_lines > 0 &&
+      priv->scrollback_count > priv->scrollback_lines + priv->scrollback_lines / 4)
+    scrollback_trim (interactive, priv->scrollback_count - priv->scrollback_lines);
+
+  g_object_notify_by_pspec (G_OBJECT (interactive), param_specs[PROP_SCROLLBACK_LENGTH]);
+  g_object_notify_by_pspec (G_OBJECT (interactive), param_specs[PROP_SCROLLBACK_SIZE]);
 
   insert_mark = gtk_text_buffer_get_insert (buffer);
 
+  gtk_text_buffer_get_end_iter (buffer, &iter);
   gtk_text_buffer_place_cursor (buffer, &iter);
-  gtk_text_view_scroll_to_mark( interactive->priv->textview,
+  gtk_text_view_scroll_to_mark( priv->textview,
                                 insert_mark, 0.0, TRUE, 0.0, 1.0);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Output is queued and written to the text view in one go before the
+ * next relayout, so a script printing many lines only makes the view
+ * revalidate once */
+static void
+gtk_inspector_interactive_add_line (GtkInspectorInteractive *interactive,
+                                    const char *str)
+{
+  if (interactive->priv->capture)
+    {
+      g_string_append (interactive->priv->capture, str);
+      g_string_append_c (interactive->priv->capture, '\n');
+      return;
+    }
+
+  /* Code the user left behind, such as a timeout, may still print */
+  if (interactive->priv->disposed)
+    {
+      g_printerr ("%s\n", str);
+      return;
+    }
+
+  g_string_append (interactive->priv->pending_output, str);
+  g_string_append_c (interactive->priv->pending_output, '\n');
+
+  if (interactive->priv->flush_id == 0)
+    interactive->priv->flush_id = g_idle_add_full (G_PRIORITY_HIGH_IDLE,
+                                                   flush_output,
+                                                   interactive,
+                                                   NULL);
+}
+
+static GtkInspectorInteractive *
+get_interactive (JSContext *context)
+{
+  GjsContext *gjs_context = (GjsContext *) JS_GetContextPrivate (context);
+
+  return GTK_INSPECTOR_INTERACTIVE (g_object_get_data (G_OBJECT (gjs_context), "interactive"));
 }
 
 static JSBool
@@ -251,162 +1080,2275 @@ gjs_print_parse_args (JSContext *context,
 
     *buffer = g_string_free(str, FALSE);
 
-    JS_EndRequest(context);
-    return JS_TRUE;
+    JS_EndRequest(context);
+    return JS_TRUE;
+}
+
+static JSBool
+gtk_inspector_interactive_print (JSContext *context,
+                                 unsigned   argc,
+                                 jsval     *vp)
+{
+  GtkInspectorInteractive *interactive = get_interactive (context);
+  jsval *argv = JS_ARGV(context, vp);
+  char *buffer;
+
+  if (!gjs_print_parse_args(context, argc, argv, &buffer))
+    return FALSE;
+
+  gtk_inspector_interactive_add_line (interactive, buffer);
+  g_free (buffer);
+
+  JS_SET_RVAL (context, vp, JSVAL_VOID);
+  return JS_TRUE;
+}
+
+/* __useSession(session) makes session the current one, for code such
+ * as a signal handler that runs on its own and belongs to one page.
+ * Without a shared context, the only session is always current. */
+static JSBool
+gtk_inspector_interactive_use_session (JSContext *context,
+                                       unsigned   argc,
+                                       jsval     *vp)
+{
+  jsval *argv = JS_ARGV(context, vp);
+  JSObject *session;
+  GList *l;
+
+  if (!gjs_parse_args (context, "__useSession", "o", argc, argv,
+                       "session", &session))
+    return JS_FALSE;
+
+  for (l = shared_pages; l; l = l->next)
+    {
+      GtkInspectorInteractive *page = GTK_INSPECTOR_INTERACTIVE (l->data);
+
+      if (page->priv->session == session)
+        {
+          use_session (page);
+          break;
+        }
+    }
+
+  JS_SET_RVAL (context, vp, JSVAL_VOID);
+  return JS_TRUE;
+}
+
+static JSBool
+name_table_range_to_array (JSContext                   *context,
+                           const GtkInspectorNameTable *table,
+                           const char                  *prefix,
+                           JSObject                    *array)
+{
+  guint begin, end, i;
+
+  gtk_inspector_name_table_range (table, prefix, &begin, &end);
+
+  for (i = begin; i < end; i++)
+    {
+      jsval name;
+
+      name = STRING_TO_JSVAL (JS_NewStringCopyZ (context, table->names[i]));
+      if (!JS_SetElement (context, array, i - begin, &name))
+        return JS_FALSE;
+    }
+
+  return JS_TRUE;
+}
+
+/* __typeMembers(typeName, forObject, prefix) returns the introspected
+ * members of a GType that start with prefix, in sorted order */
+static JSBool
+gtk_inspector_interactive_type_members (JSContext *context,
+                                        unsigned   argc,
+                                        jsval     *vp)
+{
+  jsval *argv = JS_ARGV(context, vp);
+  char *type_name = NULL;
+  char *prefix = NULL;
+  JSBool for_object;
+  const GtkInspectorNameTable *table;
+  JSObject *array;
+  GType type;
+
+  if (!gjs_parse_args (context, "__typeMembers", "sbs", argc, argv,
+                       "typeName", &type_name,
+                       "forObject", &for_object,
+                       "prefix", &prefix))
+    return JS_FALSE;
+
+  array = JS_NewArrayObject (context, 0, NULL);
+  if (array == NULL)
+    goto out;
+
+  type = g_type_from_name (type_name);
+  if (type == G_TYPE_INVALID)
+    goto out;
+
+  table = gtk_inspector_completion_lookup_type (type, for_object);
+  if (!name_table_range_to_array (context, table, prefix, array))
+    array = NULL;
+
+ out:
+  g_free (type_name);
+  g_free (prefix);
+
+  if (array == NULL)
+    return JS_FALSE;
+
+  JS_SET_RVAL (context, vp, OBJECT_TO_JSVAL (array));
+  return JS_TRUE;
+}
+
+/* __namespaceMembers(namespace, prefix) returns the names in an
+ * indexed GIR namespace that start with prefix, or null if the
+ * namespace is not (yet) indexed */
+static JSBool
+gtk_inspector_interactive_namespace_members (JSContext *context,
+                                             unsigned   argc,
+                                             jsval     *vp)
+{
+  jsval *argv = JS_ARGV(context, vp);
+  char *ns = NULL;
+  char *prefix = NULL;
+  const GtkInspectorNameTable *table;
+  JSObject *array;
+  JSBool ret = JS_FALSE;
+
+  if (!gjs_parse_args (context, "__namespaceMembers", "ss", argc, argv,
+                       "namespace", &ns,
+                       "prefix", &prefix))
+    return JS_FALSE;
+
+  table = gtk_inspector_completion_lookup_namespace (ns);
+  if (table == NULL)
+    {
+      JS_SET_RVAL (context, vp, JSVAL_NULL);
+      ret = JS_TRUE;
+      goto out;
+    }
+
+  array = JS_NewArrayObject (context, 0, NULL);
+  if (array == NULL ||
+      !name_table_range_to_array (context, table, prefix, array))
+    goto out;
+
+  JS_SET_RVAL (context, vp, OBJECT_TO_JSVAL (array));
+  ret = JS_TRUE;
+
+ out:
+  g_free (ns);
+  g_free (prefix);
+
+  return ret;
+}
+
+static gint
+compare_strings (const char **a,
+                 const char **b)
+{
+  return strcmp (*a, *b);
+}
+
+static GObject *
+gobject_from_value (JSContext *context,
+                    jsval      value)
+{
+  JSObject *obj;
+
+  if (JSVAL_IS_PRIMITIVE (value))
+    return NULL;
+
+  obj = JSVAL_TO_OBJECT (value);
+  if (!gjs_typecheck_is_object (context, obj, JS_FALSE))
+    return NULL;
+
+  return gjs_g_object_from_object (context, obj);
+}
+
+static gboolean
+weak_result_cleared (gpointer key,
+                     gpointer value,
+                     gpointer data)
+{
+  GObject *gobject = (GObject *)g_weak_ref_get ((GWeakRef *)value);
+
+  if (gobject == NULL)
+    return TRUE;
+
+  g_object_unref (gobject);
+  return FALSE;
+}
+
+/* __weakRef(value) returns a handle holding value weakly, or null if
+ * value is not a GObject. Handles whose objects are gone are dropped
+ * whenever the table has doubled since it was last swept. */
+static JSBool
+gtk_inspector_interactive_weak_ref (JSContext *context,
+                                    unsigned   argc,
+                                    jsval     *vp)
+{
+  GtkInspectorInteractive *interactive = get_interactive (context);
+  jsval *argv = JS_ARGV(context, vp);
+  GObject *gobject;
+  GWeakRef *ref;
+  guint handle;
+
+  gobject = gobject_from_value (context, argc > 0 ? argv[0] : JSVAL_VOID);
+  if (gobject == NULL)
+    {
+      JS_SET_RVAL (context, vp, JSVAL_NULL);
+      return JS_TRUE;
+    }
+
+  ref = g_new (GWeakRef, 1);
+  g_weak_ref_init (ref, gobject);
+
+  if (g_hash_table_size (interactive->priv->weak_results) >= MAX (2 * interactive->priv->weak_results_swept, 64))
+    {
+      g_hash_table_foreach_remove (interactive->priv->weak_results, weak_result_cleared, NULL);
+      interactive->priv->weak_results_swept = g_hash_table_size (interactive->priv->weak_results);
+    }
+
+  handle = ++interactive->priv->last_weak_result;
+  g_hash_table_insert (interactive->priv->weak_results, GUINT_TO_POINTER (handle), ref);
+
+  JS_SET_RVAL (context, vp, JS_NumberValue (handle));
+  return JS_TRUE;
+}
+
+/* __weakGet(handle) returns the object behind a handle from __weakRef,
+ * or null once it has been finalized */
+static JSBool
+gtk_inspector_interactive_weak_get (JSContext *context,
+                                    unsigned   argc,
+                                    jsval     *vp)
+{
+  GtkInspectorInteractive *interactive = get_interactive (context);
+  jsval *argv = JS_ARGV(context, vp);
+  guint32 handle;
+  GWeakRef *ref;
+  GObject *gobject = NULL;
+
+  if (!gjs_parse_args (context, "__weakGet", "u", argc, argv,
+                       "handle", &handle))
+    return JS_FALSE;
+
+  ref = (GWeakRef *)g_hash_table_lookup (interactive->priv->weak_results, GUINT_TO_POINTER (handle));
+  if (ref != NULL)
+    {
+      gobject = (GObject *)g_weak_ref_get (ref);
+      if (gobject == NULL)
+        g_hash_table_remove (interactive->priv->weak_results, GUINT_TO_POINTER (handle));
+    }
+
+  if (gobject == NULL)
+    {
+      JS_SET_RVAL (context, vp, JSVAL_NULL);
+      return JS_TRUE;
+    }
+
+  JS_SET_RVAL (context, vp, OBJECT_TO_JSVAL (gjs_object_from_g_object (context, gobject)));
+  g_object_unref (gobject);
+
+  return JS_TRUE;
+}
+
+/* __weakAlive(handle) returns whether the object behind a handle from
+ * __weakRef is still alive. Unlike __weakGet it doesn't wrap the
+ * object, which would keep it alive until the next collection. */
+static JSBool
+gtk_inspector_interactive_weak_alive (JSContext *context,
+                                      unsigned   argc,
+                                      jsval     *vp)
+{
+  GtkInspectorInteractive *interactive = get_interactive (context);
+  jsval *argv = JS_ARGV(context, vp);
+  guint32 handle;
+  GWeakRef *ref;
+  GObject *gobject = NULL;
+
+  if (!gjs_parse_args (context, "__weakAlive", "u", argc, argv,
+                       "handle", &handle))
+    return JS_FALSE;
+
+  ref = (GWeakRef *)g_hash_table_lookup (interactive->priv->weak_results, GUINT_TO_POINTER (handle));
+  if (ref != NULL)
+    {
+      gobject = (GObject *)g_weak_ref_get (ref);
+      if (gobject == NULL)
+        g_hash_table_remove (interactive->priv->weak_results, GUINT_TO_POINTER (handle));
+      else
+        g_object_unref (gobject);
+    }
+
+  JS_SET_RVAL (context, vp, BOOLEAN_TO_JSVAL (gobject != NULL));
+  return JS_TRUE;
+}
+
+/* __instanceSize(value) returns the size of the instance struct of a
+ * GObject, or 0 for anything else */
+static JSBool
+gtk_inspector_interactive_instance_size (JSContext *context,
+                                         unsigned   argc,
+                                         jsval     *vp)
+{
+  jsval *argv = JS_ARGV(context, vp);
+  GObject *gobject;
+  GTypeQuery query;
+
+  gobject = gobject_from_value (context, argc > 0 ? argv[0] : JSVAL_VOID);
+  if (gobject == NULL)
+    {
+      JS_SET_RVAL (context, vp, INT_TO_JSVAL (0));
+      return JS_TRUE;
+    }
+
+  g_type_query (G_OBJECT_TYPE (gobject), &query);
+
+  JS_SET_RVAL (context, vp, JS_NumberValue (query.instance_size));
+  return JS_TRUE;
+}
+
+/* __objectProperties(value) returns the names of the GObject
+ * properties of value, sorted, or an empty array for non-GObjects */
+static JSBool
+gtk_inspector_interactive_object_properties (JSContext *context,
+                                             unsigned   argc,
+                                             jsval     *vp)
+{
+  jsval *argv = JS_ARGV(context, vp);
+  GObject *gobject;
+  GParamSpec **pspecs = NULL;
+  GPtrArray *names;
+  JSObject *array;
+  guint i, n_pspecs = 0;
+
+  gobject = gobject_from_value (context, argc > 0 ? argv[0] : JSVAL_VOID);
+  if (gobject != NULL)
+    pspecs = g_object_class_list_properties (G_OBJECT_GET_CLASS (gobject), &n_pspecs);
+
+  names = g_ptr_array_sized_new (n_pspecs);
+  for (i = 0; i < n_pspecs; i++)
+    if (pspecs[i]->flags & G_PARAM_READABLE)
+      g_ptr_array_add (names, (gpointer)pspecs[i]->name);
+  g_ptr_array_sort (names, (GCompareFunc)compare_strings);
+  g_free (pspecs);
+
+  array = JS_NewArrayObject (context, 0, NULL);
+  for (i = 0; array != NULL && i < names->len; i++)
+    {
+      jsval name;
+
+      name = STRING_TO_JSVAL (JS_NewStringCopyZ (context, (const char *)names->pdata[i]));
+      if (!JS_SetElement (context, array, i, &name))
+        array = NULL;
+    }
+  g_ptr_array_unref (names);
+
+  if (array == NULL)
+    return JS_FALSE;
+
+  JS_SET_RVAL (context, vp, OBJECT_TO_JSVAL (array));
+  return JS_TRUE;
+}
+
+/* __clock() returns a monotonic time in nanoseconds. Unlike
+ * GLib.get_monotonic_time() it is not rounded to microseconds, and
+ * calling it doesn't go through introspection. */
+static JSBool
+gtk_inspector_interactive_clock (JSContext *context,
+                                 unsigned   argc,
+                                 jsval     *vp)
+{
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+
+  JS_SET_RVAL (context, vp, JS_NumberValue ((double)ts.tv_sec * 1e9 + ts.tv_nsec));
+  return JS_TRUE;
+}
+
+/* __gcCount() returns the number of garbage collections so far */
+static JSBool
+gtk_inspector_interactive_gc_count (JSContext *context,
+                                    unsigned   argc,
+                                    jsval     *vp)
+{
+  guint32 count;
+
+  count = JS_GetGCParameter (JS_GetRuntime (context), JSGC_NUMBER);
+
+  JS_SET_RVAL (context, vp, JS_NumberValue (count));
+  return JS_TRUE;
+}
+
+/* Returns str to JS, and frees it */
+static JSBool
+return_string (JSContext *context,
+               jsval     *vp,
+               gchar     *str)
+{
+  jsval retval;
+  JSBool ret;
+
+  ret = gjs_string_from_utf8 (context, str, -1, &retval);
+  g_free (str);
+
+  if (ret)
+    JS_SET_RVAL (context, vp, retval);
+  return ret;
+}
+
+/* __frameMonitorStart(widget, capacity) starts recording the frames of
+ * the toplevel of widget, replacing any monitor already running */
+static JSBool
+gtk_inspector_interactive_frame_monitor_start (JSContext *context,
+                                               unsigned   argc,
+                                               jsval     *vp)
+{
+  GtkInspectorInteractive *interactive = get_interactive (context);
+  jsval *argv = JS_ARGV(context, vp);
+  GObject *gobject;
+  GdkFrameClock *clock;
+  JSObject *obj;
+  guint32 capacity = DEFAULT_FRAME_MONITOR_CAPACITY;
+
+  if (!gjs_parse_args (context, "__frameMonitorStart", "o|u", argc, argv,
+                       "widget", &obj, "capacity", &capacity))
+    return JS_FALSE;
+
+  gobject = gobject_from_value (context, OBJECT_TO_JSVAL (obj));
+  if (gobject == NULL || !GTK_IS_WIDGET (gobject))
+    {
+      gjs_throw (context, "Frames can only be monitored for a widget");
+      return JS_FALSE;
+    }
+
+  clock = gtk_widget_get_frame_clock (gtk_widget_get_toplevel (GTK_WIDGET (gobject)));
+  if (clock == NULL)
+    {
+      gjs_throw (context, "The toplevel of %s is not realized", G_OBJECT_TYPE_NAME (gobject));
+      return JS_FALSE;
+    }
+
+  if (capacity == 0)
+    {
+      gjs_throw (context, "The frame monitor needs room for at least one frame");
+      return JS_FALSE;
+    }
+
+  g_clear_pointer (&interactive->priv->frame_monitor, gtk_inspector_frame_monitor_free);
+  interactive->priv->frame_monitor = gtk_inspector_frame_monitor_new (clock, capacity);
+
+  JS_SET_RVAL (context, vp, JSVAL_VOID);
+  return JS_TRUE;
+}
+
+/* __frameMonitorStop() stops recording and drops what was recorded */
+static JSBool
+gtk_inspector_interactive_frame_monitor_stop (JSContext *context,
+                                              unsigned   argc,
+                                              jsval     *vp)
+{
+  GtkInspectorInteractive *interactive = get_interactive (context);
+
+  g_clear_pointer (&interactive->priv->frame_monitor, gtk_inspector_frame_monitor_free);
+
+  JS_SET_RVAL (context, vp, JSVAL_VOID);
+  return JS_TRUE;
+}
+
+/* __frameMonitorReset() drops the frames recorded so far, and goes on
+ * recording */
+static JSBool
+gtk_inspector_interactive_frame_monitor_reset (JSContext *context,
+                                               unsigned   argc,
+                                               jsval     *vp)
+{
+  GtkInspectorInteractive *interactive = get_interactive (context);
+
+  if (interactive->priv->frame_monitor == NULL)
+    {
+      gjs_throw (context, "The frame monitor is not running");
+      return JS_FALSE;
+    }
+
+  gtk_inspector_frame_monitor_reset (interactive->priv->frame_monitor);
+
+  JS_SET_RVAL (context, vp, JSVAL_VOID);
+  return JS_TRUE;
+}
+
+/* __frameMonitorReport() describes the frames recorded so far */
+static JSBool
+gtk_inspector_interactive_frame_monitor_report (JSContext *context,
+                                                unsigned   argc,
+                                                jsval     *vp)
+{
+  GtkInspectorInteractive *interactive = get_interactive (context);
+
+  if (interactive->priv->frame_monitor == NULL)
+    {
+      gjs_throw (context, "The frame monitor is not running");
+      return JS_FALSE;
+    }
+
+  return return_string (context, vp,
+                        gtk_inspector_frame_monitor_report (interactive->priv->frame_monitor));
+}
+
+/* __notifyMonitorStart(subtree, capacity) starts counting the property
+ * notifications of the selected object, and of the widgets inside it
+ * if subtree is true, replacing any monitor already running. It moves
+ * on to each newly selected object until stopped. */
+static JSBool
+gtk_inspector_interactive_notify_monitor_start (JSContext *context,
+                                                unsigned   argc,
+                                                jsval     *vp)
+{
+  GtkInspectorInteractive *interactive = get_interactive (context);
+  jsval *argv = JS_ARGV(context, vp);
+  JSBool subtree = JS_FALSE;
+  guint32 capacity = DEFAULT_NOTIFY_MONITOR_CAPACITY;
+
+  if (!gjs_parse_args (context, "__notifyMonitorStart", "|bu", argc, argv,
+                       "subtree", &subtree, "capacity", &capacity))
+    return JS_FALSE;
+
+  if (interactive->priv->object == NULL)
+    {
+      gjs_throw (context, "No object is selected");
+      return JS_FALSE;
+    }
+
+  if (capacity == 0 || capacity > GTK_INSPECTOR_NOTIFY_MONITOR_MAX_CAPACITY)
+    {
+      gjs_throw (context, "The notify monitor counts from 1 to %d properties",
+                 GTK_INSPECTOR_NOTIFY_MONITOR_MAX_CAPACITY);
+      return JS_FALSE;
+    }
+
+  g_clear_pointer (&interactive->priv->notify_monitor, gtk_inspector_notify_monitor_free);
+  interactive->priv->notify_monitor = gtk_inspector_notify_monitor_new (capacity, subtree);
+  gtk_inspector_notify_monitor_set_object (interactive->priv->notify_monitor,
+                                           interactive->priv->object);
+
+  JS_SET_RVAL (context, vp, JSVAL_VOID);
+  return JS_TRUE;
+}
+
+/* __notifyMonitorStop() stops counting and drops the counts */
+static JSBool
+gtk_inspector_interactive_notify_monitor_stop (JSContext *context,
+                                               unsigned   argc,
+                                               jsval     *vp)
+{
+  GtkInspectorInteractive *interactive = get_interactive (context);
+
+  g_clear_pointer (&interactive->priv->notify_monitor, gtk_inspector_notify_monitor_free);
+
+  JS_SET_RVAL (context, vp, JSVAL_VOID);
+  return JS_TRUE;
+}
+
+/* __notifyMonitorReport(limit) lists the limit properties that changed
+ * most since the monitor started or the selection last changed */
+static JSBool
+gtk_inspector_interactive_notify_monitor_report (JSContext *context,
+                                                 unsigned   argc,
+                                                 jsval     *vp)
+{
+  GtkInspectorInteractive *interactive = get_interactive (context);
+  jsval *argv = JS_ARGV(context, vp);
+  guint32 limit;
+
+  if (!gjs_parse_args (context, "__notifyMonitorReport", "u", argc, argv,
+                       "limit", &limit))
+    return JS_FALSE;
+
+  if (interactive->priv->notify_monitor == NULL)
+    {
+      gjs_throw (context, "The notify monitor is not running");
+      return JS_FALSE;
+    }
+
+  return return_string (context, vp,
+                        gtk_inspector_notify_monitor_report (interactive->priv->notify_monitor, limit));
+}
+
+/* __traceSignals(type_name, signal_name) starts tracing a signal of a
+ * type, or all the signals of the type, its ancestors and interfaces if
+ * signal_name is omitted.
+ * Returns how many signals are now traced. */
+static JSBool
+gtk_inspector_interactive_trace_signals (JSContext *context,
+                                         unsigned   argc,
+                                         jsval     *vp)
+{
+  jsval *argv = JS_ARGV(context, vp);
+  char *type_name = NULL;
+  char *name = NULL;
+  GType type;
+  guint *ids = NULL;
+  guint i, n_ids, n_traced;
+  JSBool ret = JS_FALSE;
+
+  if (!gjs_parse_args (context, "__traceSignals", "s|s", argc, argv,
+                       "typeName", &type_name, "signalName", &name))
+    return JS_FALSE;
+
+  type = g_type_from_name (type_name);
+  if (type == G_TYPE_INVALID)
+    {
+      gjs_throw (context, "No type named %s", type_name);
+      goto out;
+    }
+
+  if (name != NULL)
+    {
+      ids = g_new (guint, 1);
+      ids[0] = g_signal_lookup (name, type);
+      n_ids = ids[0] != 0 ? 1 : 0;
+      if (n_ids == 0)
+        {
+          gjs_throw (context, "%s has no signal %s", type_name, name);
+          goto out;
+        }
+    }
+  else
+    {
+      GArray *all = g_array_new (FALSE, FALSE, sizeof (guint));
+      GType *ifaces;
+      guint n_ifaces;
+      GType t;
+
+      /* g_signal_list_ids() only lists the signals a type adds itself */
+      for (t = type; t != G_TYPE_INVALID; t = g_type_parent (t))
+        {
+          guint *own = g_signal_list_ids (t, &n_ids);
+          g_array_append_vals (all, own, n_ids);
+          g_free (own);
+        }
+
+      ifaces = g_type_interfaces (type, &n_ifaces);
+      for (i = 0; i < n_ifaces; i++)
+        {
+          guint *own = g_signal_list_ids (ifaces[i], &n_ids);
+          g_array_append_vals (all, own, n_ids);
+          g_free (own);
+        }
+      g_free (ifaces);
+
+      n_ids = all->len;
+      ids = (guint *)g_array_free (all, FALSE);
+    }
+
+  n_traced = 0;
+  for (i = 0; i < n_ids; i++)
+    if (gtk_inspector_signal_tracer_add (ids[i]))
+      n_traced++;
+
+  if (n_traced == 0)
+    {
+      gjs_throw (context, "No signals of %s can be traced", type_name);
+      goto out;
+    }
+
+  JS_SET_RVAL (context, vp, INT_TO_JSVAL (n_traced));
+  ret = JS_TRUE;
+
+ out:
+  g_free (ids);
+  g_free (type_name);
+  g_free (name);
+  return ret;
+}
+
+/* __traceStop() stops tracing all signals, keeping what was recorded */
+static JSBool
+gtk_inspector_interactive_trace_stop (JSContext *context,
+                                      unsigned   argc,
+                                      jsval     *vp)
+{
+  gtk_inspector_signal_tracer_stop ();
+
+  JS_SET_RVAL (context, vp, JSVAL_VOID);
+  return JS_TRUE;
+}
+
+/* __traceClear() forgets what was recorded */
+static JSBool
+gtk_inspector_interactive_trace_clear (JSContext *context,
+                                       unsigned   argc,
+                                       jsval     *vp)
+{
+  gtk_inspector_signal_tracer_clear ();
+
+  JS_SET_RVAL (context, vp, JSVAL_VOID);
+  return JS_TRUE;
+}
+
+/* __traceReport(kind) summarizes the recorded emissions by "signal",
+ * by "instance", or as "rate"s over the last seconds */
+static JSBool
+gtk_inspector_interactive_trace_report (JSContext *context,
+                                        unsigned   argc,
+                                        jsval     *vp)
+{
+  jsval *argv = JS_ARGV(context, vp);
+  GtkInspectorSignalReport kind;
+  char *kind_name;
+
+  if (!gjs_parse_args (context, "__traceReport", "s", argc, argv,
+                       "kind", &kind_name))
+    return JS_FALSE;
+
+  if (strcmp (kind_name, "signal") == 0)
+    kind = GTK_INSPECTOR_SIGNAL_REPORT_BY_SIGNAL;
+  else if (strcmp (kind_name, "instance") == 0)
+    kind = GTK_INSPECTOR_SIGNAL_REPORT_BY_INSTANCE;
+  else if (strcmp (kind_name, "rate") == 0)
+    kind = GTK_INSPECTOR_SIGNAL_REPORT_RATE;
+  else
+    {
+      gjs_throw (context, "Unknown report %s", kind_name);
+      g_free (kind_name);
+      return JS_FALSE;
+    }
+  g_free (kind_name);
+
+  return return_string (context, vp, gtk_inspector_signal_tracer_report (kind));
+}
+
+static gboolean
+census_check (JSContext *context)
+{
+  if (gtk_inspector_census_is_counting ())
+    return TRUE;
+
+  gjs_throw (context, "Instances are not counted; GLib only counts them with GOBJECT_DEBUG=instance-count "
+             "in builds with G_ENABLE_DEBUG, otherwise watch the types of interest first");
+  return FALSE;
+}
+
+/* __censusWatch(type_name) has us count the instances of a type and its
+ * subtypes created from now on, for when GLib does not count them */
+static JSBool
+gtk_inspector_interactive_census_watch (JSContext *context,
+                                        unsigned   argc,
+                                        jsval     *vp)
+{
+  jsval *argv = JS_ARGV(context, vp);
+  char *type_name;
+  GType type;
+  JSBool ret = JS_FALSE;
+
+  if (!gjs_parse_args (context, "__censusWatch", "s", argc, argv,
+                       "typeName", &type_name))
+    return JS_FALSE;
+
+  type = g_type_from_name (type_name);
+  if (type == G_TYPE_INVALID)
+    {
+      gjs_throw (context, "No type named %s", type_name);
+      goto out;
+    }
+
+  if (!gtk_inspector_census_watch (type))
+    {
+      gjs_throw (context, "%s is not an object type", type_name);
+      goto out;
+    }
+
+  JS_SET_RVAL (context, vp, JSVAL_VOID);
+  ret = JS_TRUE;
+
+ out:
+  g_free (type_name);
+  return ret;
+}
+
+/* __censusReport(limit) lists the limit types with the most live
+ * instances */
+static JSBool
+gtk_inspector_interactive_census_report (JSContext *context,
+                                         unsigned   argc,
+                                         jsval     *vp)
+{
+  jsval *argv = JS_ARGV(context, vp);
+  GtkInspectorCensus *census;
+  guint32 limit;
+  gchar *report;
+
+  if (!gjs_parse_args (context, "__censusReport", "u", argc, argv,
+                       "limit", &limit))
+    return JS_FALSE;
+
+  if (!census_check (context))
+    return JS_FALSE;
+
+  census = gtk_inspector_census_take ();
+  report = gtk_inspector_census_report (census, limit);
+  gtk_inspector_census_free (census);
+
+  return return_string (context, vp, report);
+}
+
+/* __censusSnapshot(name) takes a census and keeps it as name */
+static JSBool
+gtk_inspector_interactive_census_snapshot (JSContext *context,
+                                           unsigned   argc,
+                                           jsval     *vp)
+{
+  GtkInspectorInteractive *interactive = get_interactive (context);
+  jsval *argv = JS_ARGV(context, vp);
+  char *name;
+
+  if (!gjs_parse_args (context, "__censusSnapshot", "s", argc, argv,
+                       "name", &name))
+    return JS_FALSE;
+
+  if (!census_check (context))
+    {
+      g_free (name);
+      return JS_FALSE;
+    }
+
+  /* The table takes the name */
+  g_hash_table_insert (interactive->priv->census_snapshots, name,
+                       gtk_inspector_census_take ());
+
+  JS_SET_RVAL (context, vp, JSVAL_VOID);
+  return JS_TRUE;
+}
+
+/* __censusDiff(limit, from, to) compares two snapshots, or a snapshot
+ * with the current counts if to is omitted */
+static JSBool
+gtk_inspector_interactive_census_diff (JSContext *context,
+                                       unsigned   argc,
+                                       jsval     *vp)
+{
+  GtkInspectorInteractive *interactive = get_interactive (context);
+  jsval *argv = JS_ARGV(context, vp);
+  GtkInspectorCensus *before, *after, *current = NULL;
+  guint32 limit;
+  char *from, *to = NULL;
+  gchar *report = NULL;
+
+  if (!gjs_parse_args (context, "__censusDiff", "us|s", argc, argv,
+                       "limit", &limit, "from", &from, "to", &to))
+    return JS_FALSE;
+
+  if (!census_check (context))
+    goto out;
+
+  before = (GtkInspectorCensus *)g_hash_table_lookup (interactive->priv->census_snapshots, from);
+  if (before == NULL)
+    {
+      gjs_throw (context, "No snapshot named %s", from);
+      goto out;
+    }
+
+  if (to != NULL)
+    {
+      after = (GtkInspectorCensus *)g_hash_table_lookup (interactive->priv->census_snapshots, to);
+      if (after == NULL)
+        {
+          gjs_throw (context, "No snapshot named %s", to);
+          goto out;
+        }
+    }
+  else
+    {
+      after = current = gtk_inspector_census_take ();
+    }
+
+  report = gtk_inspector_census_diff (before, after, limit);
+
+ out:
+  if (current)
+    gtk_inspector_census_free (current);
+  g_free (from);
+  g_free (to);
+
+  if (report == NULL)
+    return JS_FALSE;
+  return return_string (context, vp, report);
+}
+
+/* __query(selector, root) returns the widgets matching selector in the
+ * tree of root, or of every toplevel but the inspector's own */
+static JSBool
+gtk_inspector_interactive_query (JSContext *context,
+                                 unsigned   argc,
+                                 jsval     *vp)
+{
+  GtkInspectorInteractive *interactive = get_interactive (context);
+  jsval *argv = JS_ARGV(context, vp);
+  GtkInspectorQuery *query;
+  GError *error = NULL;
+  GPtrArray *results;
+  JSObject *array;
+  char *selector;
+  JSObject *root_obj = NULL;
+  guint i;
+
+  if (!gjs_parse_args (context, "__query", "s|o", argc, argv,
+                       "selector", &selector, "root", &root_obj))
+    return JS_FALSE;
+
+  query = gtk_inspector_query_new (selector, &error);
+  g_free (selector);
+  if (query == NULL)
+    {
+      gjs_throw (context, "%s", error->message);
+      g_error_free (error);
+      return JS_FALSE;
+    }
+
+  results = g_ptr_array_new ();
+  if (root_obj != NULL)
+    {
+      GObject *root = gobject_from_value (context, OBJECT_TO_JSVAL (root_obj));
+
+      if (root == NULL || !GTK_IS_WIDGET (root))
+        {
+          gjs_throw (context, "The root of a query must be a widget");
+          gtk_inspector_query_free (query);
+          g_ptr_array_unref (results);
+          return JS_FALSE;
+        }
+      gtk_inspector_query_run (query, GTK_WIDGET (root), results);
+    }
+  else
+    {
+      GtkWidget *own = gtk_widget_get_toplevel (GTK_WIDGET (interactive));
+      GList *toplevels, *l;
+
+      toplevels = gtk_window_list_toplevels ();
+      for (l = toplevels; l; l = l->next)
+        if (l->data != own)
+          gtk_inspector_query_run (query, GTK_WIDGET (l->data), results);
+      g_list_free (toplevels);
+    }
+  gtk_inspector_query_free (query);
+
+  array = JS_NewArrayObject (context, 0, NULL);
+  for (i = 0; array != NULL && i < results->len; i++)
+    {
+      JSObject *obj = gjs_object_from_g_object (context, G_OBJECT (results->pdata[i]));
+      jsval value = OBJECT_TO_JSVAL (obj);
+
+      if (obj == NULL || !JS_SetElement (context, array, i, &value))
+        array = NULL;
+    }
+  g_ptr_array_unref (results);
+
+  if (array == NULL)
+    return JS_FALSE;
+
+  JS_SET_RVAL (context, vp, OBJECT_TO_JSVAL (array));
+  return JS_TRUE;
+}
+
+/* Ranks the candidates against the entry text after the completion
+ * prefix. The view is detached meanwhile, since the list doesn't
+ * emit row signals; in fixed height mode reattaching it is cheap. */
+static guint
+completion_refilter (GtkInspectorInteractive *interactive)
+{
+  GtkInspectorInteractivePrivate *priv = interactive->priv;
+  const gchar *text = gtk_entry_get_text (priv->entry);
+  GtkTreePath *path;
+  guint n;
+
+  gtk_tree_view_set_model (priv->completion_view, NULL);
+  n = gtk_inspector_candidate_list_filter (priv->candidates, text + strlen (priv->completion_prefix));
+  gtk_tree_view_set_model (priv->completion_view, GTK_TREE_MODEL (priv->candidates));
+
+  if (n == 0)
+    {
+      gtk_widget_hide (GTK_WIDGET (priv->completion_window));
+      return 0;
+    }
+
+  path = gtk_tree_path_new_first ();
+  gtk_tree_view_set_cursor (priv->completion_view, path, NULL, FALSE);
+  gtk_tree_path_free (path);
+  gtk_widget_show (GTK_WIDGET (priv->completion_window));
+
+  return n;
+}
+
+static void
+completion_hide (GtkInspectorInteractive *interactive)
+{
+  GtkInspectorInteractivePrivate *priv = interactive->priv;
+
+  if (priv->completion_prefix == NULL)
+    return;
+
+  g_clear_pointer (&priv->completion_prefix, g_free);
+  gtk_widget_hide (GTK_WIDGET (priv->completion_window));
+  gtk_tree_view_set_model (priv->completion_view, NULL);
+  gtk_inspector_candidate_list_set_candidates (priv->candidates, g_ptr_array_new ());
+}
+
+static gboolean
+completion_visible (GtkInspectorInteractive *interactive)
+{
+  return interactive->priv->completion_prefix != NULL &&
+         gtk_widget_get_visible (GTK_WIDGET (interactive->priv->completion_window));
+}
+
+/* Replaces the text after the prefix with the candidate in row */
+static void
+completion_accept (GtkInspectorInteractive *interactive,
+                   GtkTreePath             *path)
+{
+  GtkInspectorInteractivePrivate *priv = interactive->priv;
+  gchar *text;
+
+  text = g_strconcat (priv->completion_prefix,
+                      gtk_inspector_candidate_list_get (priv->candidates,
+                                                        gtk_tree_path_get_indices (path)[0]),
+                      NULL);
+  completion_hide (interactive);
+  gtk_entry_set_text (priv->entry, text);
+  gtk_editable_set_position (GTK_EDITABLE (priv->entry), -1);
+  g_free (text);
+}
+
+static void
+completion_move (GtkInspectorInteractive *interactive,
+                 GtkDirectionType         dir)
+{
+  GtkInspectorInteractivePrivate *priv = interactive->priv;
+  GtkTreePath *path;
+  gint row = 0;
+  gint n_rows;
+
+  gtk_tree_view_get_cursor (priv->completion_view, &path, NULL);
+  if (path)
+    {
+      row = gtk_tree_path_get_indices (path)[0];
+      gtk_tree_path_free (path);
+    }
+
+  n_rows = gtk_inspector_candidate_list_get_n_rows (priv->candidates);
+  if (dir == GTK_DIR_UP)
+    row = MAX (row - 1, 0);
+  else
+    row = MIN (row + 1, n_rows - 1);
+
+  path = gtk_tree_path_new_from_indices (row, -1);
+  gtk_tree_view_set_cursor (priv->completion_view, path, NULL, FALSE);
+  gtk_tree_path_free (path);
+}
+
+static void
+completion_row_activated (GtkTreeView             *view,
+                          GtkTreePath             *path,
+                          GtkTreeViewColumn       *column,
+                          GtkInspectorInteractive *interactive)
+{
+  completion_accept (interactive, path);
+  gtk_widget_grab_focus (GTK_WIDGET (interactive->priv->entry));
+}
+
+/* __showCompletions(candidates, start) lists the candidates for the
+ * entry text from character start on, and returns how many match it */
+static JSBool
+gtk_inspector_interactive_show_completions (JSContext *context,
+                                            unsigned   argc,
+                                            jsval     *vp)
+{
+  GtkInspectorInteractive *interactive = get_interactive (context);
+  GtkInspectorInteractivePrivate *priv = interactive->priv;
+  jsval *argv = JS_ARGV(context, vp);
+  JSObject *array;
+  guint32 start, length, i;
+  GPtrArray *names;
+  const gchar *text;
+  const gchar *pattern;
+
+  if (!gjs_parse_args (context, "__showCompletions", "ou", argc, argv,
+                       "candidates", &array, "start", &start))
+    return JS_FALSE;
+
+  if (!JS_IsArrayObject (context, array) || !JS_GetArrayLength (context, array, &length))
+    {
+      gjs_throw (context, "Completion candidates must be an array");
+      return JS_FALSE;
+    }
+
+  names = g_ptr_array_new_full (length, g_free);
+  for (i = 0; i < length; i++)
+    {
+      jsval value;
+      gchar *name;
+
+      if (!JS_GetElement (context, array, i, &value) ||
+          !gjs_string_to_utf8 (context, value, &name))
+        {
+          g_ptr_array_unref (names);
+          return JS_FALSE;
+        }
+      g_ptr_array_add (names, name);
+    }
+
+  text = gtk_entry_get_text (priv->entry);
+  pattern = g_utf8_offset_to_pointer (text, MIN ((glong)start, g_utf8_strlen (text, -1)));
+
+  g_free (priv->completion_prefix);
+  priv->completion_prefix = g_strndup (text, pattern - text);
+  gtk_inspector_candidate_list_set_candidates (priv->candidates, names);
+
+  JS_SET_RVAL (context, vp, INT_TO_JSVAL (completion_refilter (interactive)));
+  return JS_TRUE;
+}
+
+/* __hideCompletions() */
+static JSBool
+gtk_inspector_interactive_hide_completions (JSContext *context,
+                                            unsigned   argc,
+                                            jsval     *vp)
+{
+  completion_hide (get_interactive (context));
+
+  JS_SET_RVAL (context, vp, JSVAL_VOID);
+  return JS_TRUE;
+}
+
+static void
+watch_update_visible (GtkInspectorInteractive *interactive)
+{
+  gtk_widget_set_visible (GTK_WIDGET (interactive->priv->watch_window),
+                          gtk_inspector_watch_list_get_n_watches (interactive->priv->watches) > 0);
+}
+
+/* Evaluates a watch for the watch list; the summary of its value and
+ * the objects it reached come back through __watchResult. The cost
+ * shown includes making the summary. */
+static void
+watch_evaluate (GtkInspectorWatchList *watches,
+                guint                  id,
+                const gchar           *expression,
+                gpointer               data)
+{
+  GtkInspectorInteractive *interactive = GTK_INSPECTOR_INTERACTIVE (data);
+  GtkInspectorInteractivePrivate *priv = interactive->priv;
+  gint64 start;
+
+  priv->watch_objects = g_ptr_array_new_with_free_func (g_object_unref);
+
+  start = g_get_monotonic_time ();
+  call (interactive, "__watchEval", expression);
+  gtk_inspector_watch_list_set_result (watches, id,
+                                       priv->watch_value ? priv->watch_value : "<interrupted>",
+                                       g_get_monotonic_time () - start,
+                                       priv->watch_objects);
+
+  g_clear_pointer (&priv->watch_value, g_free);
+  g_clear_pointer (&priv->watch_objects, g_ptr_array_unref);
+}
+
+/* __watchAdd(expression) pins expression above the console and
+ * returns the id of the watch */
+static JSBool
+gtk_inspector_interactive_watch_add (JSContext *context,
+                                     unsigned   argc,
+                                     jsval     *vp)
+{
+  GtkInspectorInteractive *interactive = get_interactive (context);
+  jsval *argv = JS_ARGV(context, vp);
+  char *expression;
+  guint id;
+
+  if (!gjs_parse_args (context, "__watchAdd", "s", argc, argv,
+                       "expression", &expression))
+    return JS_FALSE;
+
+  if (*g_strstrip (expression) == '\0')
+    {
+      g_free (expression);
+      gjs_throw (context, "A watch needs an expression");
+      return JS_FALSE;
+    }
+
+  id = gtk_inspector_watch_list_add (interactive->priv->watches, expression);
+  watch_update_visible (interactive);
+  g_free (expression);
+
+  JS_SET_RVAL (context, vp, JS_NumberValue (id));
+  return JS_TRUE;
+}
+
+/* __watchRemove(id) unpins a watch */
+static JSBool
+gtk_inspector_interactive_watch_remove (JSContext *context,
+                                        unsigned   argc,
+                                        jsval     *vp)
+{
+  GtkInspectorInteractive *interactive = get_interactive (context);
+  jsval *argv = JS_ARGV(context, vp);
+  guint32 id;
+
+  if (!gjs_parse_args (context, "__watchRemove", "u", argc, argv,
+                       "id", &id))
+    return JS_FALSE;
+
+  if (!gtk_inspector_watch_list_remove (interactive->priv->watches, id))
+    {
+      gjs_throw (context, "There is no watch %u", id);
+      return JS_FALSE;
+    }
+  watch_update_visible (interactive);
+
+  JS_SET_RVAL (context, vp, JSVAL_VOID);
+  return JS_TRUE;
+}
+
+/* __watchClear() unpins all watches */
+static JSBool
+gtk_inspector_interactive_watch_clear (JSContext *context,
+                                       unsigned   argc,
+                                       jsval     *vp)
+{
+  GtkInspectorInteractive *interactive = get_interactive (context);
+
+  gtk_inspector_watch_list_clear (interactive->priv->watches);
+  watch_update_visible (interactive);
+
+  JS_SET_RVAL (context, vp, JSVAL_VOID);
+  return JS_TRUE;
+}
+
+/* __watchReport() lists the watches with their values and costs */
+static JSBool
+gtk_inspector_interactive_watch_report (JSContext *context,
+                                        unsigned   argc,
+                                        jsval     *vp)
+{
+  GtkInspectorInteractive *interactive = get_interactive (context);
+
+  return return_string (context, vp,
+                        gtk_inspector_watch_list_report (interactive->priv->watches));
+}
+
+/* __watchResult(value, objects) reports on the watch being evaluated:
+ * the summary of its value, and the GObjects it reached, whose
+ * notifications make it stale */
+static JSBool
+gtk_inspector_interactive_watch_result (JSContext *context,
+                                        unsigned   argc,
+                                        jsval     *vp)
+{
+  GtkInspectorInteractivePrivate *priv = get_interactive (context)->priv;
+  jsval *argv = JS_ARGV(context, vp);
+  char *value;
+  JSObject *objects;
+  guint32 length, i;
+
+  if (!gjs_parse_args (context, "__watchResult", "so", argc, argv,
+                       "value", &value, "objects", &objects))
+    return JS_FALSE;
+
+  if (priv->watch_objects == NULL)
+    {
+      g_free (value);
+      gjs_throw (context, "No watch is being evaluated");
+      return JS_FALSE;
+    }
+
+  if (!JS_IsArrayObject (context, objects) || !JS_GetArrayLength (context, objects, &length))
+    {
+      g_free (value);
+      gjs_throw (context, "The objects a watch reached must be an array");
+      return JS_FALSE;
+    }
+
+  g_ptr_array_set_size (priv->watch_objects, 0);
+  for (i = 0; i < length; i++)
+    {
+      jsval element;
+      GObject *gobject;
+
+      if (!JS_GetElement (context, objects, i, &element))
+        {
+          g_free (value);
+          return JS_FALSE;
+        }
+
+      gobject = gobject_from_value (context, element);
+      if (gobject != NULL)
+        g_ptr_array_add (priv->watch_objects, g_object_ref (gobject));
+    }
+
+  g_free (priv->watch_value);
+  priv->watch_value = value;
+
+  JS_SET_RVAL (context, vp, JSVAL_VOID);
+  return JS_TRUE;
+}
+
+static gboolean
+notify_heap (gpointer data)
+{
+  GtkInspectorInteractive *interactive = GTK_INSPECTOR_INTERACTIVE (data);
+  GList *l;
+
+  interactive->priv->heap_notify_id = 0;
+
+  /* Pages sharing the runtime share its heap */
+  if (interactive->priv->context != shared_context)
+    {
+      g_object_notify_by_pspec (G_OBJECT (interactive), param_specs[PROP_HEAP_SIZE]);
+      g_object_notify_by_pspec (G_OBJECT (interactive), param_specs[PROP_GC_COUNT]);
+      return G_SOURCE_REMOVE;
+    }
+
+  for (l = shared_pages; l; l = l->next)
+    {
+      g_object_notify_by_pspec (G_OBJECT (l->data), param_specs[PROP_HEAP_SIZE]);
+      g_object_notify_by_pspec (G_OBJECT (l->data), param_specs[PROP_GC_COUNT]);
+    }
+
+  return G_SOURCE_REMOVE;
+}
+
+/* The GC stats of a runtime are kept by the page gc_runtimes maps it
+ * to. When that page goes away and others still share the runtime,
+ * one of them takes over. */
+static void
+gc_stats_hand_over (GtkInspectorInteractive *from,
+                    GtkInspectorInteractive *to)
+{
+  GtkInspectorInteractivePrivate *priv = from->priv;
+  JSRuntime *runtime = JS_GetRuntime ((JSContext *)gjs_context_get_native_context (priv->context));
+
+  to->priv->gc_cycles = priv->gc_cycles;
+  to->priv->gc_slices = priv->gc_slices;
+  to->priv->gc_slice_start = priv->gc_slice_start;
+  to->priv->gc_cycle_time = priv->gc_cycle_time;
+  to->priv->gc_last_time = priv->gc_last_time;
+  to->priv->gc_max_time = priv->gc_max_time;
+  to->priv->gc_total_time = priv->gc_total_time;
+
+  g_hash_table_insert (gc_runtimes, runtime, to);
+}
+
+static void
+gc_slice_callback (JSRuntime               *runtime,
+                   JS::GCProgress           progress,
+                   const JS::GCDescription &desc)
+{
+  GtkInspectorInteractive *interactive;
+  GtkInspectorInteractivePrivate *priv;
+  gint64 now = g_get_monotonic_time ();
+
+  interactive = (GtkInspectorInteractive *)g_hash_table_lookup (gc_runtimes, runtime);
+  priv = interactive->priv;
+
+  switch (progress)
+    {
+    case JS::GC_CYCLE_BEGIN:
+      priv->gc_cycle_time = 0;
+      /* fall through */
+    case JS::GC_SLICE_BEGIN:
+      priv->gc_slice_start = now;
+      break;
+
+    case JS::GC_SLICE_END:
+    case JS::GC_CYCLE_END:
+      priv->gc_slices++;
+      priv->gc_cycle_time += now - priv->gc_slice_start;
+      if (progress == JS::GC_SLICE_END)
+        break;
+
+      priv->gc_cycles++;
+      priv->gc_last_time = priv->gc_cycle_time;
+      priv->gc_max_time = MAX (priv->gc_max_time, priv->gc_cycle_time);
+      priv->gc_total_time += priv->gc_cycle_time;
+
+      /* No handlers may run in the middle of a collection */
+      if (priv->heap_notify_id == 0)
+        priv->heap_notify_id = g_idle_add (notify_heap, interactive);
+      break;
+    }
+
+  if (priv->previous_gc_callback)
+    priv->previous_gc_callback (runtime, progress, desc);
+}
+
+static gboolean
+set_number (JSContext  *context,
+            JSObject   *obj,
+            const char *name,
+            double      number)
+{
+  return JS_DefineProperty (context, obj, name, JS_NumberValue (number),
+                            NULL, NULL, JSPROP_ENUMERATE);
+}
+
+/* __heapStats() describes the heap of the REPL runtime and its
+ * collections. wrappers counts the GObject wrappers of all gjs
+ * contexts in the process. */
+static JSBool
+gtk_inspector_interactive_heap_stats (JSContext *context,
+                                      unsigned   argc,
+                                      jsval     *vp)
+{
+  JSRuntime *runtime = JS_GetRuntime (context);
+  GtkInspectorInteractivePrivate *priv = GTK_INSPECTOR_INTERACTIVE (g_hash_table_lookup (gc_runtimes, runtime))->priv;
+  JSObject *stats;
+
+  stats = JS_NewObject (context, NULL, NULL, NULL);
+  if (stats == NULL)
+    return JS_FALSE;
+
+  if (!set_number (context, stats, "heapBytes", JS_GetGCParameter (runtime, JSGC_BYTES)) ||
+      !set_number (context, stats, "gcNumber", JS_GetGCParameter (runtime, JSGC_NUMBER)) ||
+      !set_number (context, stats, "cycles", priv->gc_cycles) ||
+      !set_number (context, stats, "slices", priv->gc_slices) ||
+      !set_number (context, stats, "lastMs", priv->gc_last_time / 1000.0) ||
+      !set_number (context, stats, "maxMs", priv->gc_max_time / 1000.0) ||
+      !set_number (context, stats, "totalMs", priv->gc_total_time / 1000.0) ||
+      !set_number (context, stats, "wrappers", gjs_counter_object.value) ||
+      !JS_DefineProperty (context, stats, "inProgress",
+                          BOOLEAN_TO_JSVAL (JS::IsIncrementalGCInProgress (runtime)),
+                          NULL, NULL, JSPROP_ENUMERATE))
+    return JS_FALSE;
+
+  JS_SET_RVAL (context, vp, OBJECT_TO_JSVAL (stats));
+  return JS_TRUE;
+}
+
+/* __gc() runs a full, non-incremental collection of the REPL runtime */
+static JSBool
+gtk_inspector_interactive_gc (JSContext *context,
+                              unsigned   argc,
+                              jsval     *vp)
+{
+  JS_GC (JS_GetRuntime (context));
+
+  JS_SET_RVAL (context, vp, JSVAL_VOID);
+  return JS_TRUE;
+}
+
+/* __gcSlice(ms) runs one slice of an incremental collection, starting
+ * one if none is in progress. Returns whether it is still in progress. */
+static JSBool
+gtk_inspector_interactive_gc_slice (JSContext *context,
+                                    unsigned   argc,
+                                    jsval     *vp)
+{
+  jsval *argv = JS_ARGV(context, vp);
+  JSRuntime *runtime = JS_GetRuntime (context);
+  guint32 budget;
+
+  if (!gjs_parse_args (context, "__gcSlice", "u", argc, argv,
+                       "budget", &budget))
+    return JS_FALSE;
+
+  if (JS::IsIncrementalGCInProgress (runtime))
+    JS::PrepareForIncrementalGC (runtime);
+  else
+    JS::PrepareForFullGC (runtime);
+  JS::IncrementalGC (runtime, JS::gcreason::API, budget);
+
+  JS_SET_RVAL (context, vp, BOOLEAN_TO_JSVAL (JS::IsIncrementalGCInProgress (runtime)));
+  return JS_TRUE;
+}
+
+static void
+append_phase (GString    *report,
+              const char *name,
+              gint64      duration)
+{
+  if (report->len > 0)
+    g_string_append (report, ", ");
+  g_string_append_printf (report, "%s %.1f ms", name, duration / 1000.0);
+}
+
+/* __startupReport() describes how long each startup phase took */
+static JSBool
+gtk_inspector_interactive_startup_report (JSContext *context,
+                                          unsigned   argc,
+                                          jsval     *vp)
+{
+  GtkInspectorInteractive *interactive = get_interactive (context);
+  GString *report;
+  jsval retval;
+  JSBool ret;
+
+  report = g_string_new ("");
+  append_phase (report, "widget init", interactive->priv->startup_init);
+  append_phase (report, "context", interactive->priv->startup_context);
+  append_phase (report, "first prompt", interactive->priv->startup_bootstrap);
+  if (interactive->priv->warm_id != 0)
+    g_string_append (report, ", idle imports pending");
+  else
+    append_phase (report, "idle imports", interactive->priv->startup_warm);
+
+  ret = gjs_string_from_utf8 (context, report->str, -1, &retval);
+  g_string_free (report, TRUE);
+
+  if (ret)
+    JS_SET_RVAL (context, vp, retval);
+  return ret;
+}
+
+static void
+error_reporter(JSContext *cx, const char *message, JSErrorReport *report)
+{
+  GtkInspectorInteractive *interactive = get_interactive (cx);
+  GString *line;
+
+  if (interactive->priv->in_init)
+    return;
+
+  if (!report) {
+    gtk_inspector_interactive_add_line (interactive, message);
+    return;
+  }
+
+  /* Strict warnings in a repl are just a pain, lets ignore them */
+  if (JSREPORT_IS_WARNING(report->flags) && JSREPORT_IS_STRICT(report->flags))
+    return;
+
+  line = g_string_new ("");
+  if (report->filename)
+    g_string_append_printf (line, "%s:", report->filename);
+  if (report->lineno)
+    g_string_append_printf (line, "%u:", report->lineno);
+  if (JSREPORT_IS_WARNING(report->flags))
+    g_string_append_printf (line, "%swarning: ",
+                            JSREPORT_IS_STRICT(report->flags) ? "strict " : "");
+
+  g_string_append_printf (line, message);
+
+  gtk_inspector_interactive_add_line (interactive, line->str);
+
+  g_string_free (line, TRUE);
+}
+
+/* The watchdog thread wakes the engine up every WATCHDOG_TICK_MS while
+ * an evaluation runs, so operation_callback gets a chance to stop it
+ * even if the script never returns to the main loop */
+static gpointer
+watchdog_thread (gpointer data)
+{
+  GtkInspectorInteractive *interactive = GTK_INSPECTOR_INTERACTIVE (data);
+  GtkInspectorInteractivePrivate *priv = interactive->priv;
+  JSRuntime *runtime;
+
+  runtime = JS_GetRuntime ((JSContext *)gjs_context_get_native_context (priv->context));
+
+  g_mutex_lock (&priv->watchdog_mutex);
+  while (!priv->watchdog_quit)
+    {
+      gint64 end_time;
+
+      if (!priv->evaluating)
+        {
+          g_cond_wait (&priv->watchdog_cond, &priv->watchdog_mutex);
+          continue;
+        }
+
+      end_time = g_get_monotonic_time () + WATCHDOG_TICK_MS * G_TIME_SPAN_MILLISECOND;
+      if (!g_cond_wait_until (&priv->watchdog_cond, &priv->watchdog_mutex, end_time) &&
+          priv->evaluating)
+        JS_TriggerOperationCallback (runtime);
+    }
+  g_mutex_unlock (&priv->watchdog_mutex);
+
+  return NULL;
+}
+
+static void
+watchdog_begin (GtkInspectorInteractive *interactive)
+{
+  GtkInspectorInteractivePrivate *priv = interactive->priv;
+
+  g_mutex_lock (&priv->watchdog_mutex);
+  priv->evaluating = TRUE;
+  priv->eval_start = g_get_monotonic_time ();
+  priv->eval_checks = 0;
+  priv->eval_interrupt = EVAL_INTERRUPT_NONE;
+  g_atomic_int_set (&priv->cancel_requested, 0);
+  g_clear_pointer (&priv->eval_location, g_free);
+  g_cond_signal (&priv->watchdog_cond);
+  g_mutex_unlock (&priv->watchdog_mutex);
+}
+
+static void
+watchdog_end (GtkInspectorInteractive *interactive)
+{
+  GtkInspectorInteractivePrivate *priv = interactive->priv;
+
+  g_mutex_lock (&priv->watchdog_mutex);
+  priv->evaluating = FALSE;
+  g_cond_signal (&priv->watchdog_cond);
+  g_mutex_unlock (&priv->watchdog_mutex);
+}
+
+static JSBool
+operation_callback (JSContext *cx)
+{
+  GtkInspectorInteractive *interactive = get_interactive (cx);
+  GtkInspectorInteractivePrivate *priv = interactive->priv;
+  JSScript *script;
+  unsigned lineno;
+  gint64 elapsed;
+
+  if (priv->previous_operation_callback &&
+      !priv->previous_operation_callback (cx))
+    return JS_FALSE;
+
+  if (!priv->evaluating)
+    return JS_TRUE;
+
+  priv->eval_checks++;
+  elapsed = g_get_monotonic_time () - priv->eval_start;
+
+  if (priv->eval_timeout > 0 &&
+      elapsed > (gint64)priv->eval_timeout * G_TIME_SPAN_MILLISECOND)
+    priv->eval_interrupt = EVAL_INTERRUPT_TIMEOUT;
+  else if (g_atomic_int_get (&priv->cancel_requested))
+    priv->eval_interrupt = EVAL_INTERRUPT_CANCEL;
+  else
+    return JS_TRUE;
+
+  if (JS_DescribeScriptedCaller (cx, &script, &lineno) && script != NULL)
+    priv->eval_location = g_strdup_printf ("%s:%u", JS_GetScriptFilename (cx, script), lineno);
+
+  /* Returning false without a pending exception terminates the script;
+   * unlike an exception this can't be caught by the code being run */
+  return JS_FALSE;
+}
+
+static void
+report_interrupt (GtkInspectorInteractive *interactive)
+{
+  GtkInspectorInteractivePrivate *priv = interactive->priv;
+  gchar *line;
+
+  line = g_strdup_printf ("<%s after %.3f s at %s, %u checks>",
+                          priv->eval_interrupt == EVAL_INTERRUPT_TIMEOUT ? "timed out" : "cancelled",
+                          (g_get_monotonic_time () - priv->eval_start) / (double)G_TIME_SPAN_SECOND,
+                          priv->eval_location ? priv->eval_location : "unknown location",
+                          priv->eval_checks);
+  gtk_inspector_interactive_add_line (interactive, line);
+  g_free (line);
+}
+
+/* Returns FALSE if function threw, was interrupted or returned false */
+static gboolean
+call (GtkInspectorInteractive *interactive,
+      const char *function,
+      const char *arg)
+{
+  JSContext *context;
+  JSObject *global;
+  jsval func, arg1, retval;
+  char *str;
+  GjsContext *old_current;
+  JSBool ok;
+  gboolean result;
+
+  /* The page has left its context */
+  if (interactive->priv->disposed)
+    return FALSE;
+
+  ensure_context (interactive);
+
+  context = (JSContext *)gjs_context_get_native_context (interactive->priv->context);
+  global = gjs_get_global_object (context);
+
+  old_current = push_context (interactive->priv->context);
+  use_session (interactive);
+
+  JSAutoCompartment ac(context, global);
+  JSAutoRequest ar(context);
+
+  arg1 = JSVAL_NULL;
+  if (arg != NULL)
+    {
+      if (!gjs_string_from_utf8 (context, arg, -1, &arg1))
+        g_error ("Failed to convert text to js");
+    }
+
+  if (!JS_GetProperty (context, global, function, &func))
+    g_error ("No %s function to call", function);
+
+  watchdog_begin (interactive);
+  ok = JS_CallFunctionValue (context, NULL, func, 1, &arg1, &retval);
+  watchdog_end (interactive);
+
+  if (!ok)
+    {
+      if (JS_GetPendingException (context, &retval)) {
+        str = gjs_value_debug_string (context, retval);
+        if (str)
+          {
+            g_warning (str);
+            g_free (str);
+          }
+      }
+      else if (interactive->priv->eval_interrupt != EVAL_INTERRUPT_NONE)
+        report_interrupt (interactive);
+      JS_ClearPendingException(context);
+    }
+
+  result = ok && !(JSVAL_IS_BOOLEAN (retval) && !JSVAL_TO_BOOLEAN (retval));
+
+  pop_context (interactive->priv->context, old_current);
+
+  return result;
+}
+
+/* Evaluates text as if it had been entered at the prompt. If output is
+ * given, what the evaluation prints is appended to it instead of the
+ * view. Returns FALSE if the evaluation threw or was interrupted. */
+gboolean
+gtk_inspector_interactive_eval (GtkInspectorInteractive *interactive,
+                                const gchar             *text,
+                                GString                 *output)
+{
+  GString *old_capture = interactive->priv->capture;
+  gboolean result;
+
+  interactive->priv->capture = output;
+  result = call (interactive, "__eval", text);
+  interactive->priv->capture = old_capture;
+
+  return result;
+}
+
+/* Appends line to the pending input and evaluates that once it is a
+ * compilable unit, the way lines entered at the prompt are. evaluated
+ * tells whether it was. Returns FALSE if the evaluation failed. */
+static void
+buffer_reset (GtkInspectorInteractive *interactive)
+{
+  g_string_set_size (interactive->priv->buffer, 0);
+  gtk_inspector_scan_state_init (&interactive->priv->buffer_scan);
+}
+
+/* Asks the parser whether text is a complete unit */
+static gboolean
+is_compilable (GtkInspectorInteractive *interactive,
+               const gchar             *text,
+               gsize                    length)
+{
+  JSContext *context;
+  JSObject *global;
+
+  ensure_context (interactive);
+
+  context = (JSContext *)gjs_context_get_native_context (interactive->priv->context);
+  global = gjs_get_global_object (context);
+
+  JSAutoCompartment ac(context, global);
+  JSAutoRequest ar(context);
+
+  return JS_BufferIsCompilableUnit (context, NULL, text, length);
+}
+
+/* Appends line to the pending input and returns whether that makes a
+ * complete unit. Only the new line is scanned, and the parser only
+ * runs once nothing is left open, so a long paste fed line by line
+ * stays linear. */
+static gboolean
+buffer_append (GtkInspectorInteractive *interactive,
+               const gchar             *line)
+{
+  GtkInspectorInteractivePrivate *priv = interactive->priv;
+
+  if (priv->buffer->len > 0)
+    g_string_append_c (priv->buffer, '\n');
+  g_string_append (priv->buffer, line);
+
+  gtk_inspector_scan (&priv->buffer_scan, line, -1);
+  gtk_inspector_scan (&priv->buffer_scan, "\n", 1);
+  if (!gtk_inspector_scan_state_is_complete (&priv->buffer_scan))
+    return FALSE;
+
+  return is_compilable (interactive, priv->buffer->str, priv->buffer->len);
+}
+
+gboolean
+gtk_inspector_interactive_feed (GtkInspectorInteractive *interactive,
+                                const gchar             *line,
+                                GString                 *output,
+                                gboolean                *evaluated)
+{
+  gboolean result = TRUE;
+
+  *evaluated = buffer_append (interactive, line);
+  if (*evaluated)
+    {
+      result = gtk_inspector_interactive_eval (interactive, interactive->priv->buffer->str, output);
+      buffer_reset (interactive);
+    }
+
+  return result;
+}
+
+/* Evaluates input left pending by gtk_inspector_interactive_feed(),
+ * which reports the syntax error that kept it from compiling. Returns
+ * FALSE if there was any. */
+gboolean
+gtk_inspector_interactive_finish (GtkInspectorInteractive *interactive,
+                                  GString                 *output)
+{
+  GString *buffer = interactive->priv->buffer;
+
+  if (buffer->len == 0)
+    return TRUE;
+
+  gtk_inspector_interactive_eval (interactive, buffer->str, output);
+  buffer_reset (interactive);
+
+  return FALSE;
+}
+
+/* Runs text as one unit, recorded as one history entry */
+static void
+run_unit (GtkInspectorInteractive *interactive,
+          const gchar             *text)
+{
+  gtk_inspector_history_add (interactive->priv->history, text);
+  interactive->priv->history_current = -1;
+  gtk_inspector_interactive_eval (interactive, text, NULL);
+}
+
+static void
+editor_update_label (GtkInspectorInteractive *interactive)
+{
+  const GtkInspectorScanState *state = gtk_inspector_scan_lines_get_end (interactive->priv->editor_scan);
+
+  gtk_label_set_text (interactive->priv->label,
+                      gtk_inspector_scan_state_is_complete (state) ? "edit» " : "edit… ");
+}
+
+static gboolean
+editor_visible (GtkInspectorInteractive *interactive)
+{
+  return gtk_widget_get_visible (GTK_WIDGET (interactive->priv->editor_window));
+}
+
+static void
+editor_open (GtkInspectorInteractive *interactive,
+             const gchar             *text)
+{
+  GtkInspectorInteractivePrivate *priv = interactive->priv;
+  GtkTextBuffer *text_buffer = gtk_text_view_get_buffer (priv->editor);
+  GtkTextIter end;
+
+  gtk_text_buffer_set_text (text_buffer, text, -1);
+  gtk_text_buffer_get_end_iter (text_buffer, &end);
+  gtk_text_buffer_place_cursor (text_buffer, &end);
+
+  buffer_reset (interactive);
+  gtk_entry_set_text (priv->entry, "");
+  gtk_widget_set_sensitive (GTK_WIDGET (priv->entry), FALSE);
+
+  gtk_widget_show (GTK_WIDGET (priv->editor_window));
+  gtk_widget_grab_focus (GTK_WIDGET (priv->editor));
+  editor_update_label (interactive);
+}
+
+static void
+editor_close (GtkInspectorInteractive *interactive)
+{
+  GtkInspectorInteractivePrivate *priv = interactive->priv;
+
+  gtk_widget_hide (GTK_WIDGET (priv->editor_window));
+  gtk_text_buffer_set_text (gtk_text_view_get_buffer (priv->editor), "", -1);
+
+  gtk_label_set_text (priv->label, "» ");
+  gtk_widget_set_sensitive (GTK_WIDGET (priv->entry), TRUE);
+  gtk_widget_grab_focus (GTK_WIDGET (priv->entry));
+}
+
+/* Opens the editor on the pending input, with text as its last line */
+static void
+editor_open_with_pending (GtkInspectorInteractive *interactive,
+                          const gchar             *text)
+{
+  GtkInspectorInteractivePrivate *priv = interactive->priv;
+  gchar *all;
+
+  if (priv->buffer->len > 0)
+    all = g_strconcat (priv->buffer->str, "\n", text, NULL);
+  else
+    all = g_strdup (text);
+
+  editor_open (interactive, all);
+  g_free (all);
+}
+
+static gchar *
+editor_get_line (guint    n,
+                 gpointer data)
+{
+  GtkInspectorInteractive *interactive = GTK_INSPECTOR_INTERACTIVE (data);
+  GtkTextBuffer *buffer = gtk_text_view_get_buffer (interactive->priv->editor);
+  GtkTextIter start, end;
+
+  gtk_text_buffer_get_iter_at_line (buffer, &start, n);
+  end = start;
+  if (!gtk_text_iter_ends_line (&end))
+    gtk_text_iter_forward_to_line_end (&end);
+
+  return gtk_text_buffer_get_text (buffer, &start, &end, FALSE);
+}
+
+/* Rescans from the edited line on, until the lines after the edit
+ * start in the state they did before. This runs from the after
+ * handlers of the edit itself: GtkTextBuffer emits ::changed from its
+ * own handlers, before those. */
+static void
+editor_rescan (GtkInspectorInteractive *interactive,
+               guint                    n_added)
+{
+  GtkInspectorInteractivePrivate *priv = interactive->priv;
+
+  gtk_inspector_scan_lines_update (priv->editor_scan,
+                                   priv->edit_first, priv->edit_removed, n_added,
+                                   editor_get_line, interactive);
+
+  if (editor_visible (interactive))
+    editor_update_label (interactive);
+}
+
+static void
+editor_insert_text (GtkTextBuffer           *buffer,
+                    GtkTextIter             *location,
+                    gchar                   *text,
+                    gint                     len,
+                    GtkInspectorInteractive *interactive)
+{
+  interactive->priv->edit_first = gtk_text_iter_get_line (location);
+  interactive->priv->edit_removed = 1;
+}
+
+/* location is at the end of the inserted text now, so the buffer has
+ * counted the line breaks, whichever kind they were */
+static void
+editor_inserted_text (GtkTextBuffer           *buffer,
+                      GtkTextIter             *location,
+                      gchar                   *text,
+                      gint                     len,
+                      GtkInspectorInteractive *interactive)
+{
+  editor_rescan (interactive, gtk_text_iter_get_line (location) - interactive->priv->edit_first + 1);
+}
+
+static void
+editor_delete_range (GtkTextBuffer           *buffer,
+                     GtkTextIter             *start,
+                     GtkTextIter             *end,
+                     GtkInspectorInteractive *interactive)
+{
+  interactive->priv->edit_first = gtk_text_iter_get_line (start);
+  interactive->priv->edit_removed = gtk_text_iter_get_line (end) - gtk_text_iter_get_line (start) + 1;
+}
+
+/* start and end meet where the range was now */
+static void
+editor_deleted_range (GtkTextBuffer           *buffer,
+                      GtkTextIter             *start,
+                      GtkTextIter             *end,
+                      GtkInspectorInteractive *interactive)
+{
+  editor_rescan (interactive, 1);
+}
+
+static gboolean
+editor_key_press (GtkWidget               *widget,
+                  GdkEventKey             *event,
+                  GtkInspectorInteractive *interactive)
+{
+  /* The text view takes Return with any modifier as a line break */
+  if ((event->keyval == GDK_KEY_Return || event->keyval == GDK_KEY_KP_Enter) &&
+      (event->state & gtk_accelerator_get_default_mod_mask ()) == GDK_CONTROL_MASK)
+    {
+      g_signal_emit (interactive, signals[RUN_BUFFER], 0);
+      return TRUE;
+    }
+
+  return FALSE;
+}
+
+static void
+paste_received (GtkClipboard *clipboard,
+                const gchar  *text,
+                gpointer      data)
+{
+  GtkInspectorInteractive *interactive = GTK_INSPECTOR_INTERACTIVE (data);
+  GtkEditable *editable = GTK_EDITABLE (interactive->priv->entry);
+  gint position;
+
+  if (text != NULL && !editor_visible (interactive))
+    {
+      gtk_editable_delete_selection (editable);
+      position = gtk_editable_get_position (editable);
+
+      if (strchr (text, '\n') == NULL && strchr (text, '\r') == NULL)
+        {
+          gtk_editable_insert_text (editable, text, -1, &position);
+          gtk_editable_set_position (editable, position);
+        }
+      else
+        {
+          /* Anything longer than a line goes to the editor, to be run
+           * as one unit rather than line by line */
+          gchar *before = gtk_editable_get_chars (editable, 0, position);
+          gchar *after = gtk_editable_get_chars (editable, position, -1);
+          gchar *all = g_strconcat (before, text, after, NULL);
+
+          editor_open_with_pending (interactive, all);
+          g_free (all);
+          g_free (after);
+          g_free (before);
+        }
+    }
+
+  g_object_unref (interactive);
+}
+
+static void
+entry_paste (GtkEntry                *entry,
+             GtkInspectorInteractive *interactive)
+{
+  g_signal_stop_emission_by_name (entry, "paste-clipboard");
+
+  gtk_clipboard_request_text (gtk_widget_get_clipboard (GTK_WIDGET (entry), GDK_SELECTION_CLIPBOARD),
+                              paste_received, g_object_ref (interactive));
+}
+
+static void
+edit_buffer (GtkInspectorInteractive *interactive)
+{
+  if (editor_visible (interactive) || interactive->priv->search != NULL)
+    return;
+
+  editor_open_with_pending (interactive, gtk_entry_get_text (interactive->priv->entry));
 }
 
-static JSBool
-gtk_inspector_interactive_print (JSContext *context,
-                                 unsigned   argc,
-                                 jsval     *vp)
+/* Runs the editor, or the pending input and the entry, whether or not
+ * the parser thinks it is complete; it reports any error */
+static void
+run_buffer (GtkInspectorInteractive *interactive)
 {
-  GjsContext *gjs_context = (GjsContext *) JS_GetContextPrivate (context);
-  GtkInspectorInteractive *interactive;
-  jsval *argv = JS_ARGV(context, vp);
-  char *buffer;
+  GtkInspectorInteractivePrivate *priv = interactive->priv;
+  gchar *text;
 
-  if (!gjs_print_parse_args(context, argc, argv, &buffer))
-    return FALSE;
+  if (priv->search != NULL)
+    return;
 
-  interactive = GTK_INSPECTOR_INTERACTIVE (g_object_get_data (G_OBJECT (gjs_context), "interactive"));
+  if (editor_visible (interactive))
+    {
+      GtkTextBuffer *text_buffer = gtk_text_view_get_buffer (priv->editor);
+      GtkTextIter start, end;
 
-  gtk_inspector_interactive_add_line (interactive, buffer);
-  g_free (buffer);
+      gtk_text_buffer_get_bounds (text_buffer, &start, &end);
+      text = gtk_text_buffer_get_text (text_buffer, &start, &end, FALSE);
+      editor_close (interactive);
+    }
+  else
+    {
+      const gchar *line = gtk_entry_get_text (priv->entry);
 
-  JS_SET_RVAL (context, vp, JSVAL_VOID);
-  return JS_TRUE;
+      if (priv->buffer->len > 0 && line[0] != 0)
+        text = g_strconcat (priv->buffer->str, "\n", line, NULL);
+      else
+        text = g_strconcat (priv->buffer->str, line, NULL);
+      buffer_reset (interactive);
+      gtk_label_set_text (priv->label, "» ");
+      gtk_entry_set_text (priv->entry, "");
+    }
+
+  if (text[0] != 0)
+    run_unit (interactive, text);
+  g_free (text);
 }
 
+
 static void
-error_reporter(JSContext *cx, const char *message, JSErrorReport *report)
+search_update (GtkInspectorInteractive *interactive)
 {
-  GjsContext *gjs_context = (GjsContext *) JS_GetContextPrivate (cx);
-  GtkInspectorInteractive *interactive;
-  GString *line;
+  GtkInspectorInteractivePrivate *priv = interactive->priv;
+  const gchar *match;
+  gchar *text;
+  guint n_matches;
 
-  interactive = GTK_INSPECTOR_INTERACTIVE (g_object_get_data (G_OBJECT (gjs_context), "interactive"));
+  n_matches = gtk_inspector_history_search_get_n_matches (priv->search);
+  match = gtk_inspector_history_search_get_match (priv->search, priv->search_match);
 
-  if (interactive->priv->in_init)
-    return;
+  if (match == NULL)
+    text = g_strdup ("no match");
+  else
+    text = g_strdup_printf ("%u/%u: %s", priv->search_match + 1, n_matches, match);
 
-  if (!report) {
-    gtk_inspector_interactive_add_line (interactive, message);
-    return;
-  }
+  gtk_label_set_text (priv->completion_label, text);
+  gtk_widget_show (GTK_WIDGET (priv->completion_label));
+  g_free (text);
+}
 
-  /* Strict warnings in a repl are just a pain, lets ignore them */
-  if (JSREPORT_IS_WARNING(report->flags) && JSREPORT_IS_STRICT(report->flags))
-    return;
+static void
+search_begin (GtkInspectorInteractive *interactive)
+{
+  GtkInspectorInteractivePrivate *priv = interactive->priv;
 
-  line = g_string_new ("");
-  if (report->filename)
-    g_string_append_printf (line, "%s:", report->filename);
-  if (report->lineno)
-    g_string_append_printf (line, "%u:", report->lineno);
-  if (JSREPORT_IS_WARNING(report->flags))
-    g_string_append_printf (line, "%swarning: ",
-                            JSREPORT_IS_STRICT(report->flags) ? "strict " : "");
+  completion_hide (interactive);
 
-  g_string_append_printf (line, message);
+  g_clear_pointer (&priv->saved_text, g_free);
+  priv->saved_text = g_strdup (gtk_entry_get_text (priv->entry));
 
-  gtk_inspector_interactive_add_line (interactive, line->str);
+  priv->search = gtk_inspector_history_search_new (priv->history);
+  priv->search_match = 0;
 
-  g_string_free (line, TRUE);
+  gtk_label_set_text (priv->label, "search» ");
+  gtk_entry_set_text (priv->entry, "");
+  search_update (interactive);
 }
 
+/* Leaves search mode, putting the current match in the entry if accept
+ * is set, or restoring the text from before the search otherwise */
 static void
-call (GtkInspectorInteractive *interactive,
-      const char *function,
-      const char *arg)
+search_end (GtkInspectorInteractive *interactive,
+            gboolean                 accept)
 {
-  JSContext *context;
-  JSObject *global;
-  jsval func, arg1, retval;
-  char *str;
-  GjsContext *old_current;
+  GtkInspectorInteractivePrivate *priv = interactive->priv;
+  const gchar *match = NULL;
+  gchar *text;
+
+  if (accept)
+    match = gtk_inspector_history_search_get_match (priv->search, priv->search_match);
+  text = g_strdup (match ? match : priv->saved_text);
+
+  g_clear_pointer (&priv->search, gtk_inspector_history_search_free);
+  priv->history_current = -1;
+
+  gtk_label_set_text (priv->label, priv->buffer->len > 0 ? "…" : "» ");
+  gtk_widget_hide (GTK_WIDGET (priv->completion_label));
+  gtk_entry_set_text (priv->entry, text ? text : "");
+  gtk_editable_set_position (GTK_EDITABLE (priv->entry), -1);
+  g_free (text);
+}
 
+static void
+search_history (GtkInspectorInteractive *interactive)
+{
+  GtkInspectorInteractivePrivate *priv = interactive->priv;
 
-  context = (JSContext *)gjs_context_get_native_context (interactive->priv->context);
-  global = gjs_get_global_object (context);
+  if (editor_visible (interactive))
+    return;
 
-  old_current = gjs_context_get_current ();
-  if (old_current != interactive->priv->context)
+  if (priv->search == NULL)
     {
-      gjs_context_make_current (NULL);
-      gjs_context_make_current (interactive->priv->context);
+      search_begin (interactive);
+      return;
     }
 
-  JSAutoCompartment ac(context, global);
-  JSAutoRequest ar(context);
-
-  arg1 = JSVAL_NULL;
-  if (arg != NULL)
+  if (priv->search_match + 1 >= gtk_inspector_history_search_get_n_matches (priv->search))
     {
-      if (!gjs_string_from_utf8 (context, arg, -1, &arg1))
-        g_error ("Failed to convert text to js");
+      gtk_widget_error_bell (GTK_WIDGET (interactive));
+      return;
     }
 
-  if (!JS_GetProperty (context, global, function, &func))
-    g_error ("No %s function to call", function);
-  else if (!JS_CallFunctionValue (context, NULL, func, 1,
-                                  &arg1, &retval))
+  priv->search_match++;
+  search_update (interactive);
+}
+
+static void
+entry_changed (GtkEntry *entry,
+               GtkInspectorInteractive *interactive)
+{
+  const gchar *prefix = interactive->priv->completion_prefix;
+
+  /* The list follows the name being typed, and goes away once the
+   * text before it changes or something other than a name is typed */
+  if (prefix != NULL)
     {
-      if (JS_GetPendingException (context, &retval)) {
-        str = gjs_value_debug_string (context, retval);
-        if (str)
+      const gchar *text = gtk_entry_get_text (entry);
+      const gchar *p;
+
+      if (!g_str_has_prefix (text, prefix))
+        {
+          completion_hide (interactive);
+          return;
+        }
+
+      for (p = text + strlen (prefix); *p; p++)
+        if (!g_ascii_isalnum (*p) && *p != '_' && *p != '$')
           {
-            g_warning (str);
-            g_free (str);
+            completion_hide (interactive);
+            return;
           }
-      }
-      JS_ClearPendingException(context);
-    }
 
-  if (old_current != interactive->priv->context)
-    {
-      gjs_context_make_current (NULL);
-      gjs_context_make_current (old_current);
+      completion_refilter (interactive);
+      return;
     }
-}
 
+  if (interactive->priv->search == NULL)
+    return;
+
+  gtk_inspector_history_search_set_query (interactive->priv->search,
+                                          gtk_entry_get_text (entry));
+  interactive->priv->search_match = 0;
+  search_update (interactive);
+}
 
 static void
 entry_activated (GtkEntry *entry,
                  GtkInspectorInteractive *interactive)
 {
-  JSContext *context;
-  JSObject *global;
   const char *text;
 
-  text = gtk_entry_get_text (entry);
-
-  if (text[0] == 0)
-    return;
+  if (interactive->priv->search != NULL)
+    {
+      search_end (interactive, TRUE);
+      return;
+    }
 
-  g_queue_push_head (interactive->priv->history, g_strdup (text));
-  g_free (g_queue_pop_nth (interactive->priv->history, HISTORY_LENGTH));
+  if (completion_visible (interactive))
+    {
+      GtkTreePath *path;
 
-  g_string_append (interactive->priv->buffer, text);
+      gtk_tree_view_get_cursor (interactive->priv->completion_view, &path, NULL);
+      if (path)
+        {
+          completion_accept (interactive, path);
+          gtk_tree_path_free (path);
+          return;
+        }
+    }
 
-  context = (JSContext *)gjs_context_get_native_context (interactive->priv->context);
-  global = gjs_get_global_object (context);
+  text = gtk_entry_get_text (entry);
 
-  JSAutoCompartment ac(context, global);
-  JSAutoRequest ar(context);
+  if (text[0] == 0)
+    return;
 
-  if (!JS_BufferIsCompilableUnit (context, NULL, interactive->priv->buffer->str, interactive->priv->buffer->len))
+  if (buffer_append (interactive, text))
     {
-      gtk_label_set_text (interactive->priv->label, "…");
+      /* One history entry for the whole unit */
+      run_unit (interactive, interactive->priv->buffer->str);
+      buffer_reset (interactive);
+      gtk_label_set_text (interactive->priv->label, "» ");
     }
   else
     {
-      call (interactive, "__eval", interactive->priv->buffer->str);
-
-      g_string_set_size (interactive->priv->buffer, 0);
-      gtk_label_set_text (interactive->priv->label, "» ");
+      gtk_label_set_text (interactive->priv->label, "…");
     }
 
-  interactive->priv->history_current = NULL;
+  interactive->priv->history_current = -1;
   gtk_entry_set_text (entry, "");
 }
 
@@ -415,6 +3357,9 @@ complete (GtkInspectorInteractive *interactive)
 {
   const gchar *text;
 
+  if (interactive->priv->search != NULL)
+    return;
+
   text = gtk_entry_get_text (interactive->priv->entry);
 
   call (interactive, "__complete", text);
@@ -424,18 +3369,35 @@ static void
 move_history (GtkInspectorInteractive *interactive,
               GtkDirectionType dir)
 {
-  GList *l;
+  gint l;
+
+  if (completion_visible (interactive) && (dir == GTK_DIR_UP || dir == GTK_DIR_DOWN))
+    {
+      completion_move (interactive, dir);
+      return;
+    }
+
+  if (interactive->priv->search != NULL)
+    {
+      /* Up and Down step through the matches of a search */
+      if (dir == GTK_DIR_UP)
+        search_history (interactive);
+      else if (dir == GTK_DIR_DOWN && interactive->priv->search_match > 0)
+        {
+          interactive->priv->search_match--;
+          search_update (interactive);
+        }
+      else
+        gtk_widget_error_bell (GTK_WIDGET (interactive));
+      return;
+    }
 
   switch (dir)
     {
     case GTK_DIR_UP:
-      l = interactive->priv->history_current;
-      if (l == NULL)
-        l = interactive->priv->history->head;
-      else
-        l = l->next;
+      l = interactive->priv->history_current + 1;
 
-      if (l == NULL)
+      if (l >= (gint)gtk_inspector_history_get_length (interactive->priv->history))
         {
           gtk_widget_error_bell (GTK_WIDGET (interactive));
           return;
@@ -446,13 +3408,13 @@ move_history (GtkInspectorInteractive *interactive,
     case GTK_DIR_DOWN:
 
       l = interactive->priv->history_current;
-      if (l == NULL)
+      if (l == -1)
         {
           gtk_widget_error_bell (GTK_WIDGET (interactive));
           return;
         }
 
-      l = l->prev;
+      l = l - 1;
 
       break;
 
@@ -464,7 +3426,7 @@ move_history (GtkInspectorInteractive *interactive,
       return;
     }
 
-  if (interactive->priv->history_current == NULL)
+  if (interactive->priv->history_current == -1)
     {
       g_clear_pointer (&interactive->priv->saved_text, g_free);
       interactive->priv->saved_text = g_strdup (gtk_entry_get_text (interactive->priv->entry));
@@ -478,15 +3440,65 @@ move_history (GtkInspectorInteractive *interactive,
         interactive->priv->saved_position = -1;
     }
 
-  if (l == NULL)
+  if (l == -1)
     gtk_entry_set_text (interactive->priv->entry, interactive->priv->saved_text ? interactive->priv->saved_text : "");
   else
-    gtk_entry_set_text (interactive->priv->entry, (char *)l->data);
+    gtk_entry_set_text (interactive->priv->entry, gtk_inspector_history_get (interactive->priv->history, l));
 
   gtk_editable_set_position (GTK_EDITABLE (interactive->priv->entry), interactive->priv->saved_position);
   interactive->priv->saved_position_valid = TRUE;
 }
 
+/* Escape while nothing is running abandons a partially entered
+ * multi-line statement. During an evaluation it only asks for the
+ * evaluation to be stopped, which operation_callback does on its next
+ * check. Key presses are only dispatched while the evaluation runs the
+ * main loop; one that never returns to it is stopped by the timeout. */
+static void
+cancel (GtkInspectorInteractive *interactive)
+{
+  if (interactive->priv->evaluating)
+    {
+      g_atomic_int_set (&interactive->priv->cancel_requested, 1);
+      return;
+    }
+
+  if (interactive->priv->completion_prefix != NULL)
+    {
+      completion_hide (interactive);
+      return;
+    }
+
+  if (interactive->priv->search != NULL)
+    {
+      search_end (interactive, FALSE);
+      return;
+    }
+
+  if (editor_visible (interactive))
+    {
+      editor_close (interactive);
+      return;
+    }
+
+  if (interactive->priv->buffer->len == 0)
+    return;
+
+  buffer_reset (interactive);
+  gtk_label_set_text (interactive->priv->label, "» ");
+  gtk_entry_set_text (interactive->priv->entry, "");
+}
+
+static gboolean
+entry_focus_in (GtkWidget *entry,
+                GdkEvent  *event,
+                GtkInspectorInteractive *interactive)
+{
+  ensure_context (interactive);
+
+  return FALSE;
+}
+
 static void
 cursor_pos_changed (GtkEntry *entry,
                     GParamSpec	*pspec,
@@ -507,7 +3519,11 @@ gtk_inspector_interactive_set_object (GtkInspectorInteractive *interactive,
   if (old)
     g_object_unref (old);
 
-  if (old != object)
+  if (old != object && interactive->priv->notify_monitor != NULL)
+    gtk_inspector_notify_monitor_set_object (interactive->priv->notify_monitor, object);
+
+  /* A context created later reports the selection itself */
+  if (old != object && interactive->priv->context != NULL)
     call (interactive, "__objectChanged", NULL);
 }
 
@@ -533,6 +3549,10 @@ gtk_inspector_interactive_get_property (GObject    *object,
       g_value_set_object (value, interactive->priv->entry);
       break;
 
+    case PROP_VALUE_VIEW:
+      g_value_set_object (value, interactive->priv->value_view);
+      break;
+
     case PROP_TITLE:
       g_value_set_string (value, "Interactive");
       break;
@@ -541,6 +3561,54 @@ gtk_inspector_interactive_get_property (GObject    *object,
       g_value_set_boolean (value, TRUE);
       break;
 
+    case PROP_EVAL_TIMEOUT:
+      g_value_set_uint (value, interactive->priv->eval_timeout);
+      break;
+
+    case PROP_SCROLLBACK_LINES:
+      g_value_set_uint (value, interactive->priv->scrollback_lines);
+      break;
+
+    case PROP_SCROLLBACK_LENGTH:
+      g_value_set_uint (value, interactive->priv->scrollback_count);
+      break;
+
+    case PROP_SCROLLBACK_SIZE:
+      g_value_set_uint64 (value, interactive->priv->scrollback_bytes);
+      break;
+
+    case PROP_RESULT_RETENTION:
+      g_value_set_uint (value, interactive->priv->result_retention);
+      break;
+
+    case PROP_SHARED_RUNTIME:
+      g_value_set_boolean (value, interactive->priv->shared_runtime);
+      break;
+
+    case PROP_HEAP_SIZE:
+      if (interactive->priv->context)
+        {
+          JSContext *context = (JSContext *)gjs_context_get_native_context (interactive->priv->context);
+
+          g_value_set_uint64 (value, JS_GetGCParameter (JS_GetRuntime (context), JSGC_BYTES));
+        }
+      else
+        g_value_set_uint64 (value, 0);
+      break;
+
+    case PROP_GC_COUNT:
+      if (interactive->priv->context)
+        {
+          JSContext *context = (JSContext *)gjs_context_get_native_context (interactive->priv->context);
+          GtkInspectorInteractive *owner;
+
+          owner = GTK_INSPECTOR_INTERACTIVE (g_hash_table_lookup (gc_runtimes, JS_GetRuntime (context)));
+          g_value_set_uint (value, owner->priv->gc_cycles);
+        }
+      else
+        g_value_set_uint (value, 0);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     }
@@ -560,6 +3628,24 @@ gtk_inspector_interactive_set_property (GObject      *object,
       gtk_inspector_interactive_set_object (interactive, (GObject *)g_value_get_object (value));
       break;
 
+    case PROP_EVAL_TIMEOUT:
+      interactive->priv->eval_timeout = g_value_get_uint (value);
+      break;
+
+    case PROP_SCROLLBACK_LINES:
+      scrollback_set_limit (interactive, g_value_get_uint (value));
+      break;
+
+    case PROP_RESULT_RETENTION:
+      interactive->priv->result_retention = g_value_get_uint (value);
+      break;
+
+    case PROP_SHARED_RUNTIME:
+      /* The inspector creates pages with no properties given */
+      interactive->priv->shared_runtime = g_value_get_boolean (value) ||
+                                          g_getenv ("GJS_INSPECTOR_SHARED_RUNTIME") != NULL;
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     }
@@ -578,24 +3664,42 @@ gtk_inspector_interactive_class_init (GtkInspectorInteractiveClass *klass)
   GtkBindingSet *binding_set;
 
   gtk_interactive_register_resource ();
+  gtk_inspector_signal_tracer_init ();
 
   object_class->constructed = gtk_inspector_interactive_constructed;
+  object_class->dispose = gtk_inspector_interactive_dispose;
   object_class->finalize = gtk_inspector_interactive_finalize;
   object_class->get_property = gtk_inspector_interactive_get_property;
   object_class->set_property = gtk_inspector_interactive_set_property;
 
   klass->move_history = move_history;
   klass->complete = complete;
+  klass->cancel = cancel;
+  klass->search_history = search_history;
+  klass->edit_buffer = edit_buffer;
+  klass->run_buffer = run_buffer;
 
   gtk_widget_class_set_template_from_resource (widget_class, "/org/gnome/gjs-inspector/interactive.ui");
   gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorInteractive, entry);
   gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorInteractive, label);
   gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorInteractive, completion_label);
+  gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorInteractive, completion_window);
+  gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorInteractive, completion_view);
+  gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorInteractive, watch_window);
+  gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorInteractive, watch_view);
+  gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorInteractive, editor_window);
+  gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorInteractive, editor);
   gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorInteractive, scrolled_window);
   gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorInteractive, textview);
+  gtk_widget_class_bind_template_child_private (widget_class, GtkInspectorInteractive, value_view);
 
   gtk_widget_class_bind_template_callback (widget_class, entry_activated);
+  gtk_widget_class_bind_template_callback (widget_class, entry_changed);
+  gtk_widget_class_bind_template_callback (widget_class, entry_focus_in);
   gtk_widget_class_bind_template_callback (widget_class, cursor_pos_changed);
+  gtk_widget_class_bind_template_callback (widget_class, completion_row_activated);
+  gtk_widget_class_bind_template_callback (widget_class, entry_paste);
+  gtk_widget_class_bind_template_callback (widget_class, editor_key_press);
 
   param_specs [PROP_OBJECT] =
     g_param_spec_object ("object",
@@ -627,6 +3731,16 @@ gtk_inspector_interactive_class_init (GtkInspectorInteractiveClass *klass)
   g_object_class_install_property (object_class, PROP_ENTRY,
                                    param_specs [PROP_ENTRY]);
 
+  param_specs [PROP_VALUE_VIEW] =
+    g_param_spec_object ("value-view",
+                         _("Value view"),
+                         _("Tree view showing the structure of a value."),
+                         GTK_TYPE_TREE_VIEW,
+                         (GParamFlags)(G_PARAM_READABLE |
+                                       G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_VALUE_VIEW,
+                                   param_specs [PROP_VALUE_VIEW]);
+
   param_specs [PROP_TITLE] =
     g_param_spec_string ("title",
                          _("Title"),
@@ -647,6 +3761,87 @@ gtk_inspector_interactive_class_init (GtkInspectorInteractiveClass *klass)
   g_object_class_install_property (object_class, PROP_USE_PICKER,
                                    param_specs [PROP_USE_PICKER]);
 
+  param_specs [PROP_EVAL_TIMEOUT] =
+    g_param_spec_uint ("eval-timeout",
+                       _("Evaluation timeout"),
+                       _("Time budget of a single evaluation in milliseconds, or 0 for none."),
+                       0, G_MAXUINT, DEFAULT_EVAL_TIMEOUT,
+                       (GParamFlags)(G_PARAM_READWRITE |
+                                     G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_EVAL_TIMEOUT,
+                                   param_specs [PROP_EVAL_TIMEOUT]);
+
+  param_specs [PROP_SCROLLBACK_LINES] =
+    g_param_spec_uint ("scrollback-lines",
+                       _("Scrollback lines"),
+                       _("Maximum number of output lines to keep, or 0 for no limit."),
+                       0, G_MAXUINT, DEFAULT_SCROLLBACK_LINES,
+                       (GParamFlags)(G_PARAM_READWRITE |
+                                     G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_SCROLLBACK_LINES,
+                                   param_specs [PROP_SCROLLBACK_LINES]);
+
+  param_specs [PROP_SCROLLBACK_LENGTH] =
+    g_param_spec_uint ("scrollback-length",
+                       _("Scrollback length"),
+                       _("Number of output lines currently kept."),
+                       0, G_MAXUINT, 0,
+                       (GParamFlags)(G_PARAM_READABLE |
+                                     G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_SCROLLBACK_LENGTH,
+                                   param_specs [PROP_SCROLLBACK_LENGTH]);
+
+  param_specs [PROP_SCROLLBACK_SIZE] =
+    g_param_spec_uint64 ("scrollback-size",
+                         _("Scrollback size"),
+                         _("Size in bytes of the output text currently kept."),
+                         0, G_MAXUINT64, 0,
+                         (GParamFlags)(G_PARAM_READABLE |
+                                       G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_SCROLLBACK_SIZE,
+                                   param_specs [PROP_SCROLLBACK_SIZE]);
+
+  param_specs [PROP_RESULT_RETENTION] =
+    g_param_spec_uint ("result-retention",
+                       _("Result retention"),
+                       _("Number of recent results kept alive; older GObject results are held weakly."),
+                       0, G_MAXUINT, DEFAULT_RESULT_RETENTION,
+                       (GParamFlags)(G_PARAM_READWRITE |
+                                     G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_RESULT_RETENTION,
+                                   param_specs [PROP_RESULT_RETENTION]);
+
+  param_specs [PROP_HEAP_SIZE] =
+    g_param_spec_uint64 ("heap-size",
+                         _("Heap size"),
+                         _("Size in bytes of the JavaScript heap of the REPL."),
+                         0, G_MAXUINT64, 0,
+                         (GParamFlags)(G_PARAM_READABLE |
+                                       G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_HEAP_SIZE,
+                                   param_specs [PROP_HEAP_SIZE]);
+
+  param_specs [PROP_GC_COUNT] =
+    g_param_spec_uint ("gc-count",
+                       _("GC count"),
+                       _("Number of garbage collections of the REPL heap."),
+                       0, G_MAXUINT, 0,
+                       (GParamFlags)(G_PARAM_READABLE |
+                                     G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_GC_COUNT,
+                                   param_specs [PROP_GC_COUNT]);
+
+  param_specs [PROP_SHARED_RUNTIME] =
+    g_param_spec_boolean ("shared-runtime",
+                          _("Shared runtime"),
+                          _("Whether the REPL shares its JavaScript context with the other pages that do; also set by GJS_INSPECTOR_SHARED_RUNTIME."),
+                          FALSE,
+                          (GParamFlags)(G_PARAM_READWRITE |
+                                        G_PARAM_CONSTRUCT_ONLY |
+                                        G_PARAM_STATIC_STRINGS));
+  g_object_class_install_property (object_class, PROP_SHARED_RUNTIME,
+                                   param_specs [PROP_SHARED_RUNTIME]);
+
 
   signals[COMPLETE] =
     g_signal_new ("complete",
@@ -658,6 +3853,26 @@ gtk_inspector_interactive_class_init (GtkInspectorInteractiveClass *klass)
                   G_TYPE_NONE,
                   0);
 
+  signals[EDIT_BUFFER] =
+    g_signal_new ("edit-buffer",
+                  G_TYPE_FROM_CLASS (klass),
+                  (GSignalFlags) (G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION),
+                  G_STRUCT_OFFSET (GtkInspectorInteractiveClass, edit_buffer),
+                  NULL, NULL,
+                  g_cclosure_marshal_VOID__VOID,
+                  G_TYPE_NONE,
+                  0);
+
+  signals[RUN_BUFFER] =
+    g_signal_new ("run-buffer",
+                  G_TYPE_FROM_CLASS (klass),
+                  (GSignalFlags) (G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION),
+                  G_STRUCT_OFFSET (GtkInspectorInteractiveClass, run_buffer),
+                  NULL, NULL,
+                  g_cclosure_marshal_VOID__VOID,
+                  G_TYPE_NONE,
+                  0);
+
   signals[MOVE_HISTORY] =
     g_signal_new ("move-history",
                   G_TYPE_FROM_CLASS (klass),
@@ -669,12 +3884,47 @@ gtk_inspector_interactive_class_init (GtkInspectorInteractiveClass *klass)
                   1,
                   GTK_TYPE_DIRECTION_TYPE);
 
+  signals[CANCEL] =
+    g_signal_new ("cancel",
+                  G_TYPE_FROM_CLASS (klass),
+                  (GSignalFlags) (G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION),
+                  G_STRUCT_OFFSET (GtkInspectorInteractiveClass, cancel),
+                  NULL, NULL,
+                  g_cclosure_marshal_VOID__VOID,
+                  G_TYPE_NONE,
+                  0);
+
+  signals[SEARCH_HISTORY] =
+    g_signal_new ("search-history",
+                  G_TYPE_FROM_CLASS (klass),
+                  (GSignalFlags) (G_SIGNAL_RUN_LAST | G_SIGNAL_ACTION),
+                  G_STRUCT_OFFSET (GtkInspectorInteractiveClass, search_history),
+                  NULL, NULL,
+                  g_cclosure_marshal_VOID__VOID,
+                  G_TYPE_NONE,
+                  0);
+
   binding_set = gtk_binding_set_by_class (klass);
 
   gtk_binding_entry_add_signal (binding_set,
                                 GDK_KEY_Tab, (GdkModifierType)0,
                                 "complete", 0);
 
+  gtk_binding_entry_add_signal (binding_set,
+                                GDK_KEY_Escape, (GdkModifierType)0,
+                                "cancel", 0);
+
+  gtk_binding_entry_add_signal (binding_set,
+                                GDK_KEY_r, GDK_CONTROL_MASK,
+                                "search-history", 0);
+
+  gtk_binding_entry_add_signal (binding_set,
+                                GDK_KEY_e, GDK_CONTROL_MASK,
+                                "edit-buffer", 0);
+  gtk_binding_entry_add_signal (binding_set,
+                                GDK_KEY_Return, GDK_CONTROL_MASK,
+                                "run-buffer", 0);
+
   gtk_binding_entry_add_signal (binding_set,
                                 GDK_KEY_Up, (GdkModifierType)0,
                                 "move-history", 1,
@@ -695,7 +3945,13 @@ gtk_inspector_interactive_grab_focus (GtkInspectorInteractive *interactive)
 void
 gtk_inspector_interactive_register (GTypeModule *module)
 {
-  gtk_inspector_interactive_register_type (module);
+  /* Already registered by gtk_module_init() if this was loaded through
+   * GTK_MODULES before the inspector loaded it as a page */
+  if (gtk_inspector_interactive_type_id == 0)
+    {
+      gtk_inspector_interactive_register_type (module);
+      gtk_inspector_candidate_list_register (module);
+    }
   g_io_extension_point_implement ("gtk-inspector-page",
                                   GTK_TYPE_INSPECTOR_INTERACTIVE,
                                   "interactive",
@@ -43,6 +43,10 @@ typedef struct _GtkInspectorInteractiveClass
   void (*complete)     (GtkInspectorInteractive *interactive);
   void (*move_history) (GtkInspectorInteractive *interactive,
                         GtkDirectionType dir);
+  void (*cancel)       (GtkInspectorInteractive *interactive);
+  void (*search_history) (GtkInspectorInteractive *interactive);
+  void (*edit_buffer)    (GtkInspectorInteractive *interactive);
+  void (*run_buffer)     (GtkInspectorInteractive *interactive);
 } GtkInspectorInteractiveClass;
 
 G_BEGIN_DECLS
@@ -55,6 +59,21 @@ gtk_inspector_interactive_grab_focus (GtkInspectorInteractive *interactive);
 void
 gtk_inspector_interactive_register (GTypeModule *module);
 
+gboolean
+gtk_inspector_interactive_eval (GtkInspectorInteractive *interactive,
+                                const gchar             *text,
+                                GString                 *output);
+
+gboolean
+gtk_inspector_interactive_feed (GtkInspectorInteractive *interactive,
+                                const gchar             *line,
+                                GString                 *output,
+                                gboolean                *evaluated);
+
+gboolean
+gtk_inspector_interactive_finish (GtkInspectorInteractive *interactive,
+                                  GString                 *output);
+
 G_END_DECLS
 
 #endif // _GTK_INSPECTOR_INTERACTIVE_H_
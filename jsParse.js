@@ -5,21 +5,37 @@ const GObject = imports.gi.GObject;
 
 // Returns a list of potential completions for text. Completions either
 // follow a dot (e.g. foo.ba -> bar) or they are picked from globalCompletionList (e.g. fo -> foo)
-// commandHeader is prefixed on any expression before it is eval'ed.  It will most likely
-// consist of global constants that might not carry over from the calling environment.
+// scope is an object whose properties are visible to any expression when it is eval'ed.
+// It will most likely hold global constants that might not carry over from the calling
+// environment.
 //
 // This function is likely the one you want to call from external modules
-function getCompletions(text, commandHeader, globalCompletionList) {
+//
+// The members of the last base expression completed are cached (see
+// memberCache), so pressing Tab again on the same text doesn't evaluate
+// it again.
+function getCompletions(text, scope, globalCompletionList) {
+    return findCompletions(text, scope, globalCompletionList, true);
+}
+
+// Like getCompletions, but returns every candidate for the position,
+// not only those starting with attrHead, for a fuzzy matcher to rank
+function getCandidates(text, scope, globalCompletionList) {
+    return findCompletions(text, scope, globalCompletionList, false);
+}
+
+function findCompletions(text, scope, globalCompletionList, byPrefix) {
     let methods = [];
     let expr, base;
     let attrHead = '';
     if (globalCompletionList == null) {
         const keywords = ['true', 'false', 'null', 'new', 'imports'];
         const windowProperties = Object.getOwnPropertyNames(window).filter(function(a){ return a.charAt(0) != '_' });
-        const headerProperties = getDeclaredConstants(commandHeader);
-        globalCompletionList = keywords.concat(windowProperties).concat(headerProperties);
+        const scopeProperties = scope ? Object.keys(scope) : [];
+        globalCompletionList = keywords.concat(windowProperties).concat(scopeProperties);
     }
 
+    let fullText = text;
     let offset = getExpressionOffset(text, text.length - 1);
     if (offset >= 0) {
         text = text.slice(offset);
@@ -29,9 +45,8 @@ function getCompletions(text, commandHeader, globalCompletionList) {
         if (matches) {
             [expr, base, attrHead] = matches;
 
-            methods = getPropertyNamesFromExpression(base, commandHeader).filter(function(attr) {
-                return attr.slice(0, attrHead.length) == attrHead;
-            });
+            methods = getCachedPropertyNames(fullText.slice(0, fullText.length - attrHead.length),
+                                             base, scope, byPrefix ? attrHead : '');
         }
 
         // Look for the empty expression or partially entered words
@@ -39,8 +54,9 @@ function getCompletions(text, commandHeader, globalCompletionList) {
         matches = text.match(/^(\w*)$/);
         if (text == '' || matches) {
             [expr, attrHead] = matches;
+            let head = byPrefix ? attrHead : '';
             methods = globalCompletionList.filter(function(attr) {
-                return attr.slice(0, attrHead.length) == attrHead;
+                return attr.slice(0, head.length) == head;
             });
         }
     }
@@ -137,40 +153,9 @@ function getExpressionOffset(expr, offset) {
     return offset + 1;
 }
 
-function enumerateInfo (info, for_object) {
-    let props = [];
-
-    if (info.get_type() == 7) {
-        let n = 0;
-        if (for_object) {
-            n = Gir.object_info_get_n_properties(info);
-            for (let i = 0; i < n; i++) {
-                let prop = Gir.object_info_get_property(info, i);
-                props.push (prop.get_name().replace(/-/g, '_'));
-            }
-        }
-
-        n = Gir.object_info_get_n_methods(info);
-        for (let i = 0; i < n; i++) {
-            let method = Gir.object_info_get_method(info, i);
-            let flags = Gir.function_info_get_flags (method);
-            if ((for_object && (flags & 1) != 0) ||
-                (!for_object && (flags & 1) != 1))
-                props.push (method.get_name());
-        }
-    }
-
-    if (for_object) {
-        let parent = Gir.object_info_get_parent(info);
-        if (parent) {
-            props = props.concat(enumerateInfo(parent, for_object));
-        }
-    }
-
-    return props;
-}
-
-function enumerateGObject (obj) {
+// The introspected members of a GType are enumerated once natively
+// and kept in a sorted table, so this is only a prefix range lookup.
+function enumerateGObject (obj, attrHead) {
     if (!obj) {
         return [];
     }
@@ -183,29 +168,17 @@ function enumerateGObject (obj) {
         for_object = true;
     }
 
-    let repo = Gir.Repository.get_default();
-
-    while (gtype != null) {
-        let info = repo.find_by_gtype(gtype);
-        if (info) {
-            return enumerateInfo (info, for_object);
-        }
-        if (!for_object || gtype == GObject.Object.$gtype) {
-            gtype = null;
-        } else {
-            gtype = GObject.type_parent(gtype);
-        }
-    }
+    if (gtype == null)
+        return [];
 
-    return [];
+    return __typeMembers(GObject.type_name(gtype), for_object, attrHead);
 }
 
-function enumerateGIRNamespace (obj) {
+function enumerateGIRNamespace (obj, attrHead) {
     if (!obj || typeof obj !== 'object' ||
         !obj instanceof GIRepositoryNamespace) {
         return [];
     }
-    let props = [];
     let names = Object.getOwnPropertyNames(obj);
     let repo = Gir.Repository.get_default();
     for (let i = 0; i < names.length; i++) {
@@ -219,20 +192,28 @@ function enumerateGIRNamespace (obj) {
             some_info = repo.find_by_gtype(some_type);
         if (some_info) {
             let ns = some_info.get_namespace();
-            let repo = Gir.Repository.get_default();
+
+            // The pre-imported namespaces are indexed natively in the
+            // background; only walk the infos if that isn't ready.
+            let indexed = __namespaceMembers(ns, attrHead);
+            if (indexed !== null)
+                return indexed;
+
+            let props = [];
             let n_infos =  repo.get_n_infos(ns);
             for (let i = 0; i < n_infos; i++) {
-                let info = repo.get_info (ns, i);
-                props.push(info.get_name());
+                let name = repo.get_info (ns, i).get_name();
+                if (name.slice(0, attrHead.length) == attrHead)
+                    props.push(name);
             }
-            break;
+            return props;
         }
     }
-    return props;
+    return [];
 }
 
-function enumerateGIR (obj) {
-    return enumerateGObject (obj).concat (enumerateGIRNamespace (obj));
+function enumerateGIR (obj, attrHead) {
+    return enumerateGObject (obj, attrHead).concat (enumerateGIRNamespace (obj, attrHead));
 }
 
 
@@ -251,20 +232,24 @@ function getAllProps(obj) {
     return Object.getOwnPropertyNames(obj).concat( getAllProps(Object.getPrototypeOf(obj)) );
 }
 
-// Given a string _expr_, returns all methods
+// Given a string _expr_, returns all methods starting with attrHead
 // that can be accessed via '.' notation.
 // e.g., expr="({ foo: null, bar: null, 4: null })" will
 // return ["foo", "bar", ...] but the list will not include "4",
 // since methods accessed with '.' notation must star with a letter or _.
-function getPropertyNamesFromExpression(expr, commandHeader) {
-    if (commandHeader == null) {
-        commandHeader = '';
+function getPropertyNamesFromExpression(expr, scope, attrHead) {
+    if (scope == null) {
+        scope = {};
+    }
+    if (attrHead == null) {
+        attrHead = '';
     }
 
     let obj = {};
     if (!isUnsafeExpression(expr)) {
         try {
-                obj = eval(commandHeader + expr);
+                with (scope)
+                    obj = eval(expr);
         } catch (e) {
             return [];
         }
@@ -277,8 +262,10 @@ function getPropertyNamesFromExpression(expr, commandHeader) {
     if (typeof obj === 'object' || typeof obj === 'function') {
         let allProps = [];
 
-        allProps = allProps.concat(getAllProps(obj));
-        allProps = allProps.concat(enumerateGIR(obj));
+        allProps = allProps.concat(getAllProps(obj).filter(function(attr) {
+            return attr.slice(0, attrHead.length) == attrHead;
+        }));
+        allProps = allProps.concat(enumerateGIR(obj, attrHead));
 
         // Get only things we are allowed to complete following a '.'
         allProps = allProps.filter( isValidPropertyName );
@@ -291,6 +278,42 @@ function getPropertyNamesFromExpression(expr, commandHeader) {
     return Object.keys(propsUnique).sort();
 }
 
+// The sorted members of the base expression last completed, keyed by
+// the entry text up to the final '.'.  Evaluating the base can be slow
+// and run getters on live objects, so it is only done again when that
+// text changes or invalidateCompletions() is called, which the REPL
+// does whenever it evaluates something.
+let memberCache = null;
+
+function invalidateCompletions() {
+    memberCache = null;
+}
+
+function getCachedPropertyNames(key, expr, scope, attrHead) {
+    if (memberCache === null || memberCache.key !== key || memberCache.scope !== scope)
+        memberCache = { key: key, scope: scope,
+                        members: getPropertyNamesFromExpression(expr, scope, '') };
+
+    let members = memberCache.members;
+
+    // Binary search for the first member with the prefix; those that
+    // have it follow it
+    let lo = 0, hi = members.length;
+    while (lo < hi) {
+        let mid = (lo + hi) >> 1;
+        if (members[mid] < attrHead)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    let end = lo;
+    while (end < members.length && members[end].slice(0, attrHead.length) == attrHead)
+        end++;
+
+    return members.slice(lo, end);
+}
+
 // Given a list of words, returns the longest prefix they all have in common
 function getCommonPrefix(words) {
     let word = words[0];
@@ -340,18 +363,3 @@ function isUnsafeExpression(str) {
 
     return false;
 }
-
-// Returns a list of global keywords derived from str
-function getDeclaredConstants(str) {
-    let ret = [];
-    str.split(';').forEach(function(s) {
-        let base, keyword;
-        let match = s.match(/const\s+(\w+)\s*=/);
-        if (match) {
-            [base, keyword] = match;
-            ret.push(keyword);
-        }
-    });
-
-    return ret;
-}
@@ -1,46 +1,275 @@
+#include <string.h>
+#include <unistd.h>
+
 #include <gtk/gtk.h>
+#include <gio/gunixsocketaddress.h>
+#include "fake-module.h"
+#include "input-scanner.h"
 #include "interactive.h"
+#include "repl-server.h"
 
-typedef struct _GFakeModule GFakeModule;
-typedef struct _GFakeModuleClass GFakeModuleClass;
+static gchar *connect_path = NULL;
+static gboolean batch = FALSE;
 
-struct _GFakeModule {
-  GTypeModule parent_instance;
+static GOptionEntry entries[] = {
+  { "connect", 0, 0, G_OPTION_ARG_FILENAME, &connect_path, "Evaluate standard input in the REPL served on the Unix socket PATH", "PATH" },
+  { "batch", 0, 0, G_OPTION_ARG_NONE, &batch, "Evaluate FILE, or standard input, without a window and print the output", NULL },
+  { NULL }
 };
 
-struct _GFakeModuleClass
+static gboolean
+send_request (GOutputStream *out,
+              const gchar   *text,
+              gsize          length,
+              GError       **error)
 {
-  GTypeModuleClass parent_class;
-};
+  guint32 header = GUINT32_TO_BE ((guint32)length);
 
-static void
-g_fake_module_init (GFakeModule *module)
-{
+  return g_output_stream_write_all (out, &header, sizeof (header), NULL, NULL, error) &&
+         g_output_stream_write_all (out, text, length, NULL, NULL, error);
 }
 
-static gboolean
-g_fake_module_load_module (GTypeModule *gmodule)
+/* Prints the output of one response, returns its status or -1 */
+static gint
+receive_response (GInputStream  *in,
+                  GError       **error)
 {
-  return TRUE;
+  guint32 length;
+  gchar *payload;
+  gsize n;
+  gint status;
+
+  if (!g_input_stream_read_all (in, &length, sizeof (length), &n, NULL, error))
+    return -1;
+  if (n < sizeof (length))
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_CLOSED, "Connection closed");
+      return -1;
+    }
+
+  length = GUINT32_FROM_BE (length);
+  if (length == 0 || length > GTK_INSPECTOR_REPL_MAX_FRAME)
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA, "Invalid response");
+      return -1;
+    }
+
+  payload = g_malloc (length);
+  if (!g_input_stream_read_all (in, payload, length, &n, NULL, error) || n < length)
+    {
+      if (error && *error == NULL)
+        g_set_error (error, G_IO_ERROR, G_IO_ERROR_CLOSED, "Connection closed");
+      g_free (payload);
+      return -1;
+    }
+
+  fwrite (payload + 1, 1, length - 1, stdout);
+  fflush (stdout);
+  status = (guchar)payload[0];
+  g_free (payload);
+
+  return status;
 }
 
-static void
-g_fake_module_unload_module (GTypeModule *gmodule)
+/* Sends standard input as requests of whole units: lines are gathered
+ * until no bracket, string or comment is left open at the end of one,
+ * as told by the input scanner, like at the prompt. The client has no
+ * parser, so a statement broken elsewhere, like an if with its body on
+ * the next line and no braces, is sent in two halves and fails; brace
+ * it or keep it on one line. Blank lines between units are skipped.
+ * When the input is not a terminal, all requests are sent before
+ * reading any response, so the server evaluates them as one batch. */
+static int
+run_client (const gchar *path)
 {
+  GSocketClient *client;
+  GSocketAddress *address;
+  GSocketConnection *connection;
+  GInputStream *in;
+  GOutputStream *out;
+  GIOChannel *input;
+  GError *error = NULL;
+  gboolean interactive = isatty (STDIN_FILENO);
+  GtkInspectorScanState state;
+  GString *unit;
+  gchar *line;
+  gsize length;
+  guint sent = 0, received = 0;
+  int ret = 0;
+
+  client = g_socket_client_new ();
+  address = g_unix_socket_address_new (path);
+  connection = g_socket_client_connect (client, G_SOCKET_CONNECTABLE (address), NULL, &error);
+  g_object_unref (address);
+  g_object_unref (client);
+
+  if (connection == NULL)
+    {
+      g_printerr ("Could not connect to %s: %s\n", path, error->message);
+      g_error_free (error);
+      return 1;
+    }
+
+  in = g_io_stream_get_input_stream (G_IO_STREAM (connection));
+  out = g_io_stream_get_output_stream (G_IO_STREAM (connection));
+  input = g_io_channel_unix_new (STDIN_FILENO);
+  unit = g_string_new (NULL);
+  gtk_inspector_scan_state_init (&state);
+
+  while (TRUE)
+    {
+      gboolean eof, ok;
+
+      eof = g_io_channel_read_line (input, &line, &length, NULL, NULL) != G_IO_STATUS_NORMAL;
+      if (!eof)
+        {
+          gsize len = strlen (line);
+
+          /* Drop the line terminator */
+          while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+            len--;
+
+          if (len > 0 || unit->len > 0)
+            {
+              if (unit->len > 0)
+                g_string_append_c (unit, '\n');
+              g_string_append_len (unit, line, len);
+              gtk_inspector_scan (&state, line, len);
+              gtk_inspector_scan (&state, "\n", 1);
+            }
+          g_free (line);
+
+          if (unit->len == 0 || !gtk_inspector_scan_state_is_complete (&state))
+            continue;
+        }
+      else if (unit->len == 0)
+        {
+          break;
+        }
+
+      /* At the end, whatever is left goes, for the server to report */
+      ok = send_request (out, unit->str, unit->len, &error);
+      g_string_truncate (unit, 0);
+      gtk_inspector_scan_state_init (&state);
+      if (!ok)
+        break;
+      sent++;
+
+      if (interactive)
+        {
+          gint status = receive_response (in, &error);
+
+          if (status < 0)
+            break;
+          if (status != GTK_INSPECTOR_REPL_OK)
+            ret = 1;
+          received++;
+        }
+
+      if (eof)
+        break;
+    }
+
+  while (error == NULL && received < sent)
+    {
+      gint status = receive_response (in, &error);
+
+      if (status < 0)
+        break;
+      if (status != GTK_INSPECTOR_REPL_OK)
+        ret = 1;
+      received++;
+    }
+
+  if (error)
+    {
+      g_printerr ("%s\n", error->message);
+      g_error_free (error);
+      ret = 1;
+    }
+
+  g_string_free (unit, TRUE);
+  g_io_channel_unref (input);
+  g_object_unref (connection);
+
+  return ret;
 }
 
-static void
-g_fake_module_class_init (GFakeModuleClass *class)
+/* Feeds the script to a page that is never shown, line by line like at
+ * the prompt, and writes out the output of each unit as it completes.
+ * Only the page is created, so this runs on any display backend. */
+static int
+run_batch (const gchar *filename)
 {
-  GTypeModuleClass *type_module_class = G_TYPE_MODULE_CLASS (class);
+  GtkWidget *interactive;
+  GTypeModule *module;
+  GIOChannel *input;
+  GString *output;
+  GError *error = NULL;
+  gchar *line;
+  gsize length;
+  GIOStatus status;
+  int ret = 0;
 
-  type_module_class->load    = g_fake_module_load_module;
-  type_module_class->unload  = g_fake_module_unload_module;
-}
+  if (filename == NULL || g_str_equal (filename, "-"))
+    input = g_io_channel_unix_new (STDIN_FILENO);
+  else
+    input = g_io_channel_new_file (filename, "r", &error);
+
+  if (input == NULL)
+    {
+      g_printerr ("%s\n", error->message);
+      g_error_free (error);
+      return 2;
+    }
+
+  g_io_extension_point_register ("gtk-inspector-page");
+  module = gtk_inspector_fake_module_new ();
+  gtk_inspector_interactive_register (module);
 
+  interactive = g_object_ref_sink (g_object_new (GTK_TYPE_INSPECTOR_INTERACTIVE, NULL));
+  output = g_string_new (NULL);
 
-G_DEFINE_TYPE (GFakeModule, g_fake_module, G_TYPE_TYPE_MODULE);
+  while ((status = g_io_channel_read_line (input, &line, &length, NULL, &error)) == G_IO_STATUS_NORMAL)
+    {
+      gboolean evaluated;
+      gsize len = strlen (line);
 
+      while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+        line[--len] = '\0';
+
+      if (!gtk_inspector_interactive_feed (GTK_INSPECTOR_INTERACTIVE (interactive), line, output, &evaluated))
+        ret = 1;
+      g_free (line);
+
+      if (evaluated)
+        {
+          fwrite (output->str, 1, output->len, stdout);
+          fflush (stdout);
+          g_string_truncate (output, 0);
+        }
+    }
+
+  if (status == G_IO_STATUS_ERROR)
+    {
+      g_printerr ("%s\n", error->message);
+      g_error_free (error);
+      ret = 2;
+    }
+  else if (!gtk_inspector_interactive_finish (GTK_INSPECTOR_INTERACTIVE (interactive), output))
+    {
+      ret = 1;
+    }
+
+  fwrite (output->str, 1, output->len, stdout);
+  fflush (stdout);
+
+  g_string_free (output, TRUE);
+  g_object_unref (interactive);
+  g_io_channel_unref (input);
+
+  return ret;
+}
 
 int
 main (int argc,
@@ -49,6 +278,33 @@ main (int argc,
   GtkWidget *window;
   GtkWidget *interactive;
   GTypeModule *module;
+  GOptionContext *option_context;
+  GError *error = NULL;
+
+  option_context = g_option_context_new ("[FILE]");
+  g_option_context_add_main_entries (option_context, entries, NULL);
+  g_option_context_add_group (option_context, gtk_get_option_group (FALSE));
+  if (!g_option_context_parse (option_context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return 1;
+    }
+  g_option_context_free (option_context);
+
+  if (connect_path)
+    return run_client (connect_path);
+
+  if (batch)
+    {
+      if (!gtk_init_check (&argc, &argv))
+        {
+          g_printerr ("Cannot open a display. For headless use, run under a virtual one "
+                      "such as xvfb-run, or set GDK_BACKEND=broadway with broadwayd running.\n");
+          return 2;
+        }
+
+      return run_batch (argc > 1 ? argv[1] : NULL);
+    }
 
   gtk_init (&argc, &argv);
 
@@ -58,7 +314,7 @@ main (int argc,
 
   g_io_extension_point_register ("gtk-inspector-page");
 
-  module = g_object_new (g_fake_module_get_type (), NULL);
+  module = gtk_inspector_fake_module_new ();
 
   gtk_inspector_interactive_register (module);
 
@@ -0,0 +1,316 @@
+/*
+ * Copyright (c) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include <gtk/gtk.h>
+
+#include "notify-monitor.h"
+#include "handler-list.h"
+
+/* A property that keeps changing is the usual cause of a relayout
+ * loop, so this counts ::notify per object and property. The counts
+ * live in an open addressing table allocated up front with at least
+ * twice as many slots as properties it takes, so counting a
+ * notification is a probe or two and never allocates. Once the table
+ * is full, the notifications of properties not in it are only counted
+ * in total.
+ *
+ * The subtree is the widgets inside the object when it is selected;
+ * widgets added later are not watched. The report names them by
+ * buildable id or widget name where they have one, and otherwise by
+ * their place in a depth-first walk of the subtree from the object. */
+
+typedef struct
+{
+  gpointer    instance;     /* only compared, may be gone by now */
+  GParamSpec *pspec;        /* NULL for an empty slot */
+  GType       type;
+  guint64     count;
+  guint64     reported;     /* count at the previous report */
+} NotifyEntry;
+
+struct _GtkInspectorNotifyMonitor
+{
+  NotifyEntry *slots;
+  guint        n_slots;     /* a power of two */
+  guint        capacity;
+  guint        n_entries;
+  gboolean     subtree;
+
+  GtkInspectorHandlerList *handlers; /* in depth-first order */
+
+  guint64      total;
+  guint64      total_reported;
+  guint64      dropped;
+  gint64       start;
+  gint64       last_report;
+};
+
+static guint
+hash_entry (gpointer    instance,
+            GParamSpec *pspec)
+{
+  guint32 h;
+
+  h = (guint32)(GPOINTER_TO_SIZE (instance) >> 3) * 31 + (guint32)(GPOINTER_TO_SIZE (pspec) >> 3);
+  h ^= h >> 16;
+  h *= 0x45d9f3b;
+  h ^= h >> 16;
+
+  return h;
+}
+
+static void
+object_notify (GObject                   *object,
+               GParamSpec                *pspec,
+               GtkInspectorNotifyMonitor *monitor)
+{
+  guint mask = monitor->n_slots - 1;
+  NotifyEntry *entry;
+  guint i;
+
+  monitor->total++;
+
+  /* There are more slots than entries, so this finds an empty one */
+  for (i = hash_entry (object, pspec) & mask; ; i = (i + 1) & mask)
+    {
+      entry = &monitor->slots[i];
+      if (entry->pspec == NULL)
+        break;
+      if (entry->instance == object && entry->pspec == pspec)
+        {
+          entry->count++;
+          return;
+        }
+    }
+
+  if (monitor->n_entries == monitor->capacity)
+    {
+      monitor->dropped++;
+      return;
+    }
+
+  entry->instance = object;
+  entry->pspec = g_param_spec_ref (pspec);
+  entry->type = G_OBJECT_TYPE (object);
+  entry->count = 1;
+  entry->reported = 0;
+  monitor->n_entries++;
+}
+
+static void
+connect_object (GtkInspectorNotifyMonitor *monitor,
+                GObject                   *object)
+{
+  gtk_inspector_handler_list_add (monitor->handlers, object,
+                                  g_signal_connect (object, "notify", G_CALLBACK (object_notify), monitor));
+}
+
+static void
+connect_child (GtkWidget *widget,
+               gpointer   data)
+{
+  GtkInspectorNotifyMonitor *monitor = (GtkInspectorNotifyMonitor *)data;
+
+  connect_object (monitor, G_OBJECT (widget));
+  if (GTK_IS_CONTAINER (widget))
+    gtk_container_forall (GTK_CONTAINER (widget), connect_child, monitor);
+}
+
+static void
+clear_counts (GtkInspectorNotifyMonitor *monitor)
+{
+  guint i;
+
+  for (i = 0; i < monitor->n_slots; i++)
+    if (monitor->slots[i].pspec)
+      g_param_spec_unref (monitor->slots[i].pspec);
+
+  memset (monitor->slots, 0, monitor->n_slots * sizeof (NotifyEntry));
+  monitor->n_entries = 0;
+  monitor->total = 0;
+  monitor->total_reported = 0;
+  monitor->dropped = 0;
+  monitor->start = monitor->last_report = g_get_monotonic_time ();
+}
+
+GtkInspectorNotifyMonitor *
+gtk_inspector_notify_monitor_new (guint    capacity,
+                                  gboolean subtree)
+{
+  GtkInspectorNotifyMonitor *monitor;
+  guint64 n_slots;
+
+  g_return_val_if_fail (capacity > 0, NULL);
+  g_return_val_if_fail (capacity <= GTK_INSPECTOR_NOTIFY_MONITOR_MAX_CAPACITY, NULL);
+
+  /* The probe loop relies on an empty slot, so there must be more
+   * slots than capacity; computed wide so it can't wrap to 0 */
+  for (n_slots = 1; n_slots < 2 * (guint64)capacity; n_slots <<= 1)
+    ;
+
+  monitor = g_new0 (GtkInspectorNotifyMonitor, 1);
+  monitor->capacity = capacity;
+  monitor->n_slots = (guint)n_slots;
+  monitor->slots = g_new0 (NotifyEntry, monitor->n_slots);
+  monitor->subtree = subtree;
+  monitor->handlers = gtk_inspector_handler_list_new ();
+  monitor->start = monitor->last_report = g_get_monotonic_time ();
+
+  return monitor;
+}
+
+void
+gtk_inspector_notify_monitor_free (GtkInspectorNotifyMonitor *monitor)
+{
+  gtk_inspector_handler_list_free (monitor->handlers);
+  clear_counts (monitor);
+  g_free (monitor->slots);
+  g_free (monitor);
+}
+
+void
+gtk_inspector_notify_monitor_set_object (GtkInspectorNotifyMonitor *monitor,
+                                         GObject                   *object)
+{
+  gtk_inspector_handler_list_disconnect_all (monitor->handlers);
+  clear_counts (monitor);
+
+  if (object == NULL)
+    return;
+
+  connect_object (monitor, object);
+  if (monitor->subtree && GTK_IS_CONTAINER (object))
+    gtk_container_forall (GTK_CONTAINER (object), connect_child, monitor);
+}
+
+/* The instance is only compared until it is found alive among the
+ * objects connected to */
+static void
+append_instance (GString                   *report,
+                 GtkInspectorNotifyMonitor *monitor,
+                 gpointer                   instance)
+{
+  guint i, n = gtk_inspector_handler_list_get_length (monitor->handlers);
+
+  for (i = 0; i < n; i++)
+    {
+      GObject *object = gtk_inspector_handler_list_get_object (monitor->handlers, i);
+      const gchar *name = NULL;
+
+      if (object != (GObject *)instance)
+        {
+          g_clear_object (&object);
+          continue;
+        }
+
+      if (GTK_IS_BUILDABLE (object))
+        name = gtk_buildable_get_name (GTK_BUILDABLE (object));
+      /* Without a name of its own, a widget gives its type name */
+      if (name == NULL && GTK_IS_WIDGET (object) &&
+          g_strcmp0 (gtk_widget_get_name (GTK_WIDGET (object)), G_OBJECT_TYPE_NAME (object)) != 0)
+        name = gtk_widget_get_name (GTK_WIDGET (object));
+
+      if (name != NULL)
+        g_string_append_printf (report, " \"%s\"", name);
+      else
+        g_string_append_printf (report, " #%u", i);
+      g_object_unref (object);
+      return;
+    }
+
+  g_string_append (report, " (finalized)");
+}
+
+static gint
+compare_counts (gconstpointer a,
+                gconstpointer b)
+{
+  const NotifyEntry *ea = *(const NotifyEntry **)a;
+  const NotifyEntry *eb = *(const NotifyEntry **)b;
+
+  return (ea->count < eb->count) - (ea->count > eb->count);
+}
+
+gchar *
+gtk_inspector_notify_monitor_report (GtkInspectorNotifyMonitor *monitor,
+                                     guint                      limit)
+{
+  gint64 now = g_get_monotonic_time ();
+  gdouble elapsed = MAX (now - monitor->start, 1) / (gdouble)G_TIME_SPAN_SECOND;
+  gdouble recent = MAX (now - monitor->last_report, 1) / (gdouble)G_TIME_SPAN_SECOND;
+  GPtrArray *entries;
+  GString *report;
+  guint i;
+
+  report = g_string_new (NULL);
+  g_string_append_printf (report,
+                          "%" G_GUINT64_FORMAT " notifications in %.1f s of %u objects, "
+                          "%.1f/s overall, %.1f/s since the last report",
+                          monitor->total, elapsed, gtk_inspector_handler_list_get_length (monitor->handlers),
+                          monitor->total / elapsed,
+                          (monitor->total - monitor->total_reported) / recent);
+
+  entries = g_ptr_array_sized_new (monitor->n_entries);
+  for (i = 0; i < monitor->n_slots; i++)
+    if (monitor->slots[i].pspec)
+      g_ptr_array_add (entries, &monitor->slots[i]);
+  g_ptr_array_sort (entries, compare_counts);
+
+  if (entries->len > 0)
+    g_string_append_printf (report, "\n%10s %10s %10s  %s", "count", "/s", "recent/s", "property");
+
+  for (i = 0; i < entries->len && i < limit; i++)
+    {
+      NotifyEntry *entry = (NotifyEntry *)g_ptr_array_index (entries, i);
+
+      g_string_append_printf (report, "\n%10" G_GUINT64_FORMAT " %10.1f %10.1f  %s",
+                              entry->count,
+                              entry->count / elapsed,
+                              (entry->count - entry->reported) / recent,
+                              g_type_name (entry->type));
+      if (monitor->subtree)
+        append_instance (report, monitor, entry->instance);
+      g_string_append_printf (report, ":%s", entry->pspec->name);
+    }
+
+  if (entries->len > limit)
+    g_string_append_printf (report, "\n%u more properties changed", entries->len - limit);
+
+  if (monitor->dropped > 0)
+    g_string_append_printf (report,
+                            "\n%" G_GUINT64_FORMAT " notifications of properties beyond the first %u were only counted in total",
+                            monitor->dropped, monitor->capacity);
+
+  for (i = 0; i < entries->len; i++)
+    {
+      NotifyEntry *entry = (NotifyEntry *)g_ptr_array_index (entries, i);
+
+      entry->reported = entry->count;
+    }
+  monitor->total_reported = monitor->total;
+  monitor->last_report = now;
+
+  g_ptr_array_unref (entries);
+
+  return g_string_free (report, FALSE);
+}
+
+// vim: set et sw=2 ts=2:
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _GTK_INSPECTOR_NOTIFY_MONITOR_H_
+#define _GTK_INSPECTOR_NOTIFY_MONITOR_H_
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+typedef struct _GtkInspectorNotifyMonitor GtkInspectorNotifyMonitor;
+
+/* Far more properties than change in any application, and a table of a
+ * few megabytes */
+#define GTK_INSPECTOR_NOTIFY_MONITOR_MAX_CAPACITY 65536
+
+/* Counts the property notifications of an object, and of the widgets
+ * inside it if subtree is set, in a table of capacity properties, from
+ * 1 to GTK_INSPECTOR_NOTIFY_MONITOR_MAX_CAPACITY */
+GtkInspectorNotifyMonitor *
+gtk_inspector_notify_monitor_new (guint    capacity,
+                                  gboolean subtree);
+
+void
+gtk_inspector_notify_monitor_free (GtkInspectorNotifyMonitor *monitor);
+
+/* Starts over with object, which may be NULL */
+void
+gtk_inspector_notify_monitor_set_object (GtkInspectorNotifyMonitor *monitor,
+                                         GObject                   *object);
+
+/* The limit properties that changed most, with their rates overall and
+ * since the previous report, as text */
+gchar *
+gtk_inspector_notify_monitor_report (GtkInspectorNotifyMonitor *monitor,
+                                     guint                      limit);
+
+G_END_DECLS
+
+#endif // _GTK_INSPECTOR_NOTIFY_MONITOR_H_
+
+// vim: set et sw=2 ts=2:
@@ -0,0 +1,379 @@
+/*
+ * Copyright (c) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <glib/gstdio.h>
+#include <gio/gunixsocketaddress.h>
+
+#include "repl-server.h"
+
+/* Connections are read with large async reads from the main loop.
+ * Every complete request that a read brings in is evaluated right
+ * there, back to back, and the responses are queued for one write, so
+ * a client that sends a batch of requests at once gets them all done
+ * in one main loop dispatch. */
+
+#define READ_SIZE 65536
+
+typedef struct _GtkInspectorReplServer GtkInspectorReplServer;
+
+typedef struct
+{
+  GtkInspectorReplServer *server;   /* NULL once the server is gone */
+  GSocketConnection      *connection;
+  GCancellable           *cancellable;
+  GByteArray             *in;
+  GByteArray             *out;      /* responses not yet being written */
+  GByteArray             *writing;  /* responses being written */
+  guint                   pending;  /* async operations in flight */
+  gboolean                closing;
+  guint8                  buffer[READ_SIZE];
+} ReplConnection;
+
+struct _GtkInspectorReplServer
+{
+  GtkInspectorInteractive *interactive;     /* owns the server */
+  GSocketService          *service;
+  gchar                   *path;
+  GList                   *connections;
+};
+
+static void start_read (ReplConnection *conn);
+static void start_write (ReplConnection *conn);
+
+static void
+connection_close (ReplConnection *conn)
+{
+  conn->closing = TRUE;
+  g_cancellable_cancel (conn->cancellable);
+
+  /* The last callback to run frees it */
+  if (conn->pending > 0)
+    return;
+
+  if (conn->server)
+    conn->server->connections = g_list_remove (conn->server->connections, conn);
+
+  g_io_stream_close (G_IO_STREAM (conn->connection), NULL, NULL);
+  g_object_unref (conn->connection);
+  g_object_unref (conn->cancellable);
+  g_byte_array_unref (conn->in);
+  g_byte_array_unref (conn->out);
+  if (conn->writing)
+    g_byte_array_unref (conn->writing);
+  g_free (conn);
+}
+
+static void
+append_response (ReplConnection *conn,
+                 guint8          status,
+                 const gchar    *output,
+                 gsize           length)
+{
+  guint32 header = GUINT32_TO_BE ((guint32)(length + 1));
+
+  g_byte_array_append (conn->out, (const guint8 *)&header, sizeof (header));
+  g_byte_array_append (conn->out, &status, 1);
+  g_byte_array_append (conn->out, (const guint8 *)output, length);
+}
+
+/* Evaluates every complete request in conn->in. Returns FALSE if the
+ * client sent something that isn't a request. */
+static gboolean
+process_requests (ReplConnection *conn)
+{
+  GString *output = g_string_new (NULL);
+  gsize offset = 0;
+  gboolean valid = TRUE;
+
+  /* The server may go away if an evaluation runs the main loop */
+  while (conn->server != NULL && conn->in->len - offset >= 4)
+    {
+      const guint8 *frame = conn->in->data + offset;
+      guint32 length;
+      gchar *text;
+
+      memcpy (&length, frame, sizeof (length));
+      length = GUINT32_FROM_BE (length);
+
+      if (length > GTK_INSPECTOR_REPL_MAX_FRAME)
+        {
+          valid = FALSE;
+          break;
+        }
+      if (conn->in->len - offset - 4 < length)
+        break;
+
+      text = g_strndup ((const gchar *)frame + 4, length);
+      offset += 4 + length;
+
+      if (strlen (text) != length || !g_utf8_validate (text, length, NULL))
+        {
+          static const gchar message[] = "Request is not valid UTF-8\n";
+
+          append_response (conn, GTK_INSPECTOR_REPL_INVALID, message, sizeof (message) - 1);
+        }
+      else
+        {
+          gboolean ok;
+
+          g_string_truncate (output, 0);
+          ok = gtk_inspector_interactive_eval (conn->server->interactive, text, output);
+          append_response (conn, ok ? GTK_INSPECTOR_REPL_OK : GTK_INSPECTOR_REPL_FAILED,
+                           output->str, output->len);
+        }
+
+      g_free (text);
+    }
+
+  g_byte_array_remove_range (conn->in, 0, offset);
+  g_string_free (output, TRUE);
+
+  return valid;
+}
+
+static void
+read_done (GObject      *source,
+           GAsyncResult *result,
+           gpointer      data)
+{
+  ReplConnection *conn = (ReplConnection *)data;
+  gssize n;
+
+  conn->pending--;
+  n = g_input_stream_read_finish (G_INPUT_STREAM (source), result, NULL);
+
+  if (n <= 0 || conn->closing || conn->server == NULL)
+    {
+      /* A write still in flight closes once the responses are out */
+      conn->closing = TRUE;
+      if (conn->pending == 0)
+        connection_close (conn);
+      return;
+    }
+
+  g_byte_array_append (conn->in, conn->buffer, n);
+
+  if (!process_requests (conn))
+    {
+      connection_close (conn);
+      return;
+    }
+
+  /* Otherwise write_done picks the new responses up */
+  if (conn->writing == NULL)
+    start_write (conn);
+  start_read (conn);
+}
+
+static void
+start_read (ReplConnection *conn)
+{
+  GInputStream *stream = g_io_stream_get_input_stream (G_IO_STREAM (conn->connection));
+
+  conn->pending++;
+  g_input_stream_read_async (stream, conn->buffer, READ_SIZE, G_PRIORITY_DEFAULT,
+                             conn->cancellable, read_done, conn);
+}
+
+static void
+write_done (GObject      *source,
+            GAsyncResult *result,
+            gpointer      data)
+{
+  ReplConnection *conn = (ReplConnection *)data;
+  gssize n;
+
+  conn->pending--;
+  n = g_output_stream_write_finish (G_OUTPUT_STREAM (source), result, NULL);
+
+  if (n < 0)
+    {
+      connection_close (conn);
+      return;
+    }
+
+  g_byte_array_remove_range (conn->writing, 0, n);
+  if (conn->writing->len == 0)
+    {
+      g_byte_array_unref (conn->writing);
+      conn->writing = NULL;
+    }
+
+  start_write (conn);
+
+  if (conn->closing && conn->pending == 0)
+    connection_close (conn);
+}
+
+static void
+start_write (ReplConnection *conn)
+{
+  GOutputStream *stream = g_io_stream_get_output_stream (G_IO_STREAM (conn->connection));
+
+  if (conn->writing == NULL)
+    {
+      if (conn->out->len == 0)
+        return;
+      conn->writing = conn->out;
+      conn->out = g_byte_array_new ();
+    }
+
+  conn->pending++;
+  g_output_stream_write_async (stream, conn->writing->data, conn->writing->len,
+                               G_PRIORITY_DEFAULT, conn->cancellable, write_done, conn);
+}
+
+static gboolean
+incoming (GSocketService     *service,
+          GSocketConnection  *connection,
+          GObject            *source_object,
+          gpointer            data)
+{
+  GtkInspectorReplServer *server = (GtkInspectorReplServer *)data;
+  ReplConnection *conn;
+
+  conn = g_new0 (ReplConnection, 1);
+  conn->server = server;
+  conn->connection = (GSocketConnection *)g_object_ref (connection);
+  conn->cancellable = g_cancellable_new ();
+  conn->in = g_byte_array_new ();
+  conn->out = g_byte_array_new ();
+  server->connections = g_list_prepend (server->connections, conn);
+
+  start_read (conn);
+
+  return TRUE;
+}
+
+/* A socket left behind by a process that is gone refuses connections,
+ * and is removed. One that something still serves is left alone. */
+static gboolean
+remove_stale_socket (const gchar  *path,
+                     GError      **error)
+{
+  struct sockaddr_un addr;
+  GStatBuf st;
+  gboolean in_use;
+  int fd;
+
+  if (g_lstat (path, &st) != 0 || !S_ISSOCK (st.st_mode) ||
+      strlen (path) >= sizeof (addr.sun_path))
+    return TRUE;
+
+  fd = socket (AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd == -1)
+    return TRUE;
+
+  memset (&addr, 0, sizeof (addr));
+  addr.sun_family = AF_UNIX;
+  strcpy (addr.sun_path, path);
+
+  in_use = connect (fd, (struct sockaddr *)&addr, sizeof (addr)) == 0;
+  if (!in_use && errno == ECONNREFUSED)
+    g_unlink (path);
+  close (fd);
+
+  if (in_use)
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_ADDRESS_IN_USE,
+                   "Another process is serving %s", path);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+server_free (gpointer data)
+{
+  GtkInspectorReplServer *server = (GtkInspectorReplServer *)data;
+  GList *l;
+
+  g_socket_service_stop (server->service);
+  g_socket_listener_close (G_SOCKET_LISTENER (server->service));
+  g_object_unref (server->service);
+  g_unlink (server->path);
+
+  for (l = server->connections; l; l = l->next)
+    {
+      ReplConnection *conn = (ReplConnection *)l->data;
+
+      conn->server = NULL;
+      g_cancellable_cancel (conn->cancellable);
+      conn->closing = TRUE;
+    }
+  g_list_free (server->connections);
+
+  g_free (server->path);
+  g_free (server);
+}
+
+gboolean
+gtk_inspector_repl_server_start (GtkInspectorInteractive  *interactive,
+                                 const gchar              *path,
+                                 GError                  **error)
+{
+  GtkInspectorReplServer *server;
+  GSocketAddress *address;
+  mode_t mask;
+  gboolean ok;
+
+  if (!remove_stale_socket (path, error))
+    return FALSE;
+
+  server = g_new0 (GtkInspectorReplServer, 1);
+  server->interactive = interactive;
+  server->path = g_strdup (path);
+  server->service = g_socket_service_new ();
+
+  /* Anyone who can connect can run code in the application, so the
+   * socket is created accessible to the user only, rather than
+   * chmod'ed after it has been connectable */
+  address = g_unix_socket_address_new (path);
+  mask = umask (077);
+  ok = g_socket_listener_add_address (G_SOCKET_LISTENER (server->service), address,
+                                      G_SOCKET_TYPE_STREAM, G_SOCKET_PROTOCOL_DEFAULT,
+                                      NULL, NULL, error);
+  umask (mask);
+  g_object_unref (address);
+
+  if (!ok)
+    {
+      g_object_unref (server->service);
+      g_free (server->path);
+      g_free (server);
+      return FALSE;
+    }
+
+  g_signal_connect (server->service, "incoming", G_CALLBACK (incoming), server);
+  g_socket_service_start (server->service);
+
+  g_object_set_data_full (G_OBJECT (interactive), "gtk-inspector-repl-server", server, server_free);
+
+  return TRUE;
+}
+
+// vim: set et sw=2 ts=2:
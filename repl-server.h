@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _GTK_INSPECTOR_REPL_SERVER_H_
+#define _GTK_INSPECTOR_REPL_SERVER_H_
+
+#include "interactive.h"
+
+G_BEGIN_DECLS
+
+/* Serves the REPL of an interactive page on a Unix socket.
+ *
+ * Requests are frames of a 32-bit big-endian length followed by that
+ * many bytes of UTF-8 JavaScript. Each gets a response frame in order:
+ * a 32-bit big-endian length, then a status byte, then the output of
+ * the evaluation, length - 1 bytes of UTF-8. */
+
+#define GTK_INSPECTOR_REPL_OK      0
+#define GTK_INSPECTOR_REPL_FAILED  1   /* threw or was interrupted */
+#define GTK_INSPECTOR_REPL_INVALID 2   /* not UTF-8 */
+
+#define GTK_INSPECTOR_REPL_MAX_FRAME (16 * 1024 * 1024)
+
+/* Serves interactive on path until it is finalized, when the socket is
+ * removed again. Fails if another process is serving path. */
+gboolean
+gtk_inspector_repl_server_start (GtkInspectorInteractive  *interactive,
+                                 const gchar              *path,
+                                 GError                  **error);
+
+G_END_DECLS
+
+#endif // _GTK_INSPECTOR_REPL_SERVER_H_
+
+// vim: set et sw=2 ts=2:
@@ -1,61 +1,509 @@
 /* -*- mode: js2; js2-basic-offset: 4; indent-tabs-mode: nil -*- */
 
-var evalResults = [];
-var offset = 0;
+// Each result is kept as { value: v } while it is one of the last
+// __inspector.result_retention results.  After that GObjects are only
+// held weakly through { handle: h }, and anything else is dropped.
+// Dropped and collected results are deleted, leaving holes, so a long
+// session only keeps entries for results that can still be had.  The
+// results are those of the current session, see createSession.
+const PRUNE_INTERVAL = 64;
+
+function addResult (value)
+{
+    let results = __session.results;
+    let offset = __session.offset;
+
+    results[offset] = { value: value };
+
+    let old = offset - __inspector.result_retention;
+    if (old >= 0 && results[old] && 'value' in results[old]) {
+        let handle = __weakRef(results[old].value);
+        if (handle === null) {
+            delete results[old];
+            __session.dropped++;
+        } else {
+            results[old] = { handle: handle };
+        }
+    }
+
+    if (offset % PRUNE_INTERVAL == PRUNE_INTERVAL - 1)
+        pruneResults();
+
+    return __session.offset++;
+}
+
+// Deletes the weakly held results whose objects have been finalized
+function pruneResults ()
+{
+    let results = __session.results;
+
+    for (let i in results) {
+        if ('handle' in results[i] && !__weakAlive(results[i].handle)) {
+            delete results[i];
+            __session.collected++;
+        }
+    }
+}
 
 function getResult (n)
 {
-    return evalResults[n];
+    let entry = __session.results[n];
+    if (entry === undefined) {
+        if (n >= 0 && n < __session.offset)
+            throw new Error("r(" + n + ") was dropped by the retention policy or has been collected");
+        throw new Error("r(" + n + ") does not exist");
+    }
+    if ('value' in entry)
+        return entry.value;
+
+    let obj = __weakGet(entry.handle);
+    if (obj === null) {
+        delete __session.results[n];
+        __session.collected++;
+        throw new Error("r(" + n + ") has been collected");
+    }
+    return obj;
+}
+
+// Shallow estimate of what a retained value keeps alive: the instance
+// struct of a GObject, the characters of a string and the slots of an
+// array, but nothing they point to
+function retainedSize (value)
+{
+    if (typeof value === 'string')
+        return value.length * 2;
+    if (value === null || typeof value !== 'object')
+        return 0;
+
+    let size = __instanceSize(value);
+    if (size == 0 && Array.isArray(value))
+        size = value.length * 8;
+    return size;
+}
+
+// The byte count is shallow, see retainedSize, so a retained container
+// may keep much more alive than it shows
+function retained ()
+{
+    let strong = 0, gobjects = 0, bytes = 0, alive = 0;
+
+    pruneResults();
+
+    for (let i in __session.results) {
+        let entry = __session.results[i];
+        if ('value' in entry) {
+            strong++;
+            if (__instanceSize(entry.value) > 0)
+                gobjects++;
+            bytes += retainedSize(entry.value);
+        } else {
+            alive++;
+        }
+    }
+
+    print ("strongly retained: " + strong + " results (" + gobjects + " GObjects, ~" + bytes + " bytes shallow)");
+    print ("weakly retained: " + alive + " alive, " + __session.collected + " collected");
+    print ("dropped: " + __session.dropped);
+}
+
+// Shows value in the value view, as a new result
+function inspect (value)
+{
+    let n = addResult(value);
+    print ("r(" + n + ") = " + ValueView.summarize(value));
+    ValueView.showValue("r(" + n + ")", n);
+}
+
+// frames.start([widget [, capacity]]) records the frames of the
+// toplevel of widget, or of the selected object
+var frames = {
+    start: function(widget, capacity) {
+        if (widget === undefined)
+            widget = __inspector.object;
+        if (capacity === undefined)
+            __frameMonitorStart(widget);
+        else
+            __frameMonitorStart(widget, capacity);
+    },
+    stop: function() {
+        __frameMonitorStop();
+    },
+    // Starts over, e.g. to leave out the frames of getting ready
+    reset: function() {
+        __frameMonitorReset();
+    },
+    report: function() {
+        print (__frameMonitorReport());
+    }
+};
+
+// trace.add(spec) traces a signal given as 'GtkWidget::size-allocate',
+// or all signals of a type given by name or as its constructor
+var trace = {
+    add: function(spec) {
+        let type = spec, signal;
+        if (typeof spec === 'function' && spec.$gtype)
+            type = imports.gi.GObject.type_name(spec.$gtype);
+        else if (String(spec).indexOf('::') >= 0)
+            [type, signal] = String(spec).split('::');
+
+        let n = signal === undefined ? __traceSignals(type) : __traceSignals(type, signal);
+        print ("tracing " + n + (n == 1 ? " signal" : " signals"));
+    },
+    stop: function() {
+        __traceStop();
+    },
+    clear: function() {
+        __traceClear();
+    },
+    bySignal: function() {
+        print (__traceReport('signal'));
+    },
+    byInstance: function() {
+        print (__traceReport('instance'));
+    },
+    rate: function() {
+        print (__traceReport('rate'));
+    }
+};
+
+// Property notification counts of the selected object, see
+// notify-monitor.cpp.  changes.start(true) also counts the widgets
+// inside it.  The monitor moves on to each newly selected object.
+const CHANGES_LIMIT = 20;
+
+var changes = {
+    start: function(subtree, capacity) {
+        if (capacity === undefined)
+            __notifyMonitorStart(!!subtree);
+        else
+            __notifyMonitorStart(!!subtree, capacity);
+    },
+    stop: function() {
+        __notifyMonitorStop();
+    },
+    report: function(limit) {
+        print (__notifyMonitorReport(limit || CHANGES_LIMIT));
+    }
+};
+
+// Live instance counts per type, see census.cpp.  Unless GLib counts
+// instances itself, census.watch('GtkWidget') is needed first, and only
+// instances created after it are counted.
+const CENSUS_LIMIT = 30;
+
+var census = {
+    watch: function(type) {
+        __censusWatch(type);
+    },
+    show: function(limit) {
+        print (__censusReport(limit || CENSUS_LIMIT));
+    },
+    snapshot: function(name) {
+        __censusSnapshot(name);
+    },
+    // census.diff('A') compares snapshot A with now
+    diff: function(from, to) {
+        if (to === undefined)
+            print (__censusDiff(CENSUS_LIMIT, from));
+        else
+            print (__censusDiff(CENSUS_LIMIT, from, to));
+    }
+};
+
+// watch.add(expr) pins expr above the console, see watch.js.  It is
+// evaluated again when a GObject it reached last time notifies, at
+// most once per frame.
+var watch = {
+    add: function(expression) {
+        print ("watch " + __watchAdd(String(expression)));
+    },
+    remove: function(id) {
+        __watchRemove(id);
+    },
+    clear: function() {
+        __watchClear();
+    },
+    list: function() {
+        print (__watchReport());
+    }
+};
+
+function watchEval (expression)
+{
+    return imports.inspector.watch.evaluate(expression);
 }
 
-var commandHeader =
-  "const GLib = imports.gi.GLib;" +
-  "const GObject = imports.gi.GObject;" +
-  "const Gio = imports.gi.Gio;" +
-  "const Pango = imports.gi.Pango;" +
-  "const Cairo = imports.cairo;" +
-  "const Gtk = imports.gi.Gtk;" +
-  "const r = imports.inspector.repl.getResult;";
+// heap() describes the JS heap of the REPL itself, so its overhead can
+// be told apart from the application's
+function heap ()
+{
+    let stats = __heapStats();
+    print ("heap: " + (stats.heapBytes / 1024).toFixed(0) + " kB, " +
+           stats.wrappers + " GObject wrappers in the process");
+    print ("collections: " + stats.cycles + " (" + stats.slices + " slices), last " +
+           stats.lastMs.toFixed(2) + " ms, max " + stats.maxMs.toFixed(2) +
+           " ms, total " + stats.totalMs.toFixed(2) + " ms" +
+           (stats.inProgress ? ", incremental collection in progress" : ""));
+}
+
+// gc() collects fully, gc(ms) runs one incremental slice of ms
+function gc (budget)
+{
+    let before = __heapStats().heapBytes;
+    if (budget === undefined)
+        __gc();
+    else if (__gcSlice(budget))
+        print ("collection in progress");
+    let after = __heapStats().heapBytes;
+    print ("heap: " + (before / 1024).toFixed(0) + " kB -> " + (after / 1024).toFixed(0) + " kB");
+}
+
+function startup ()
+{
+    print (__startupReport());
+}
+
+// %bench runs this many times unless told otherwise, after a tenth as
+// many warm-up runs to get lazy initialization and the JIT out of the way
+const DEFAULT_BENCH_RUNS = 100;
+
+// %time keeps running until it has measured this long, or this often
+const TIME_BUDGET_NS = 100e6;
+const TIME_MAX_RUNS = 1000;
+
+// Turns text into a function, so it is compiled once rather than on
+// every run.  Statements that aren't an expression are wrapped as is.
+function compileSnippet (text)
+{
+    let f;
+    try {
+        with (__session.scope)
+            f = eval ("(function () { return (" + text + "\n); })");
+    } catch (e) {
+        if (!(e instanceof SyntaxError))
+            throw e;
+        with (__session.scope)
+            f = eval ("(function () { " + text + "\n})");
+    }
+    return f;
+}
+
+// The smallest interval two back to back __clock() calls can measure
+var clockOverhead = -1;
+
+function measureClockOverhead ()
+{
+    if (clockOverhead < 0) {
+        clockOverhead = Infinity;
+        for (let i = 0; i < 100; i++) {
+            let start = __clock();
+            clockOverhead = Math.min(clockOverhead, __clock() - start);
+        }
+    }
+    return clockOverhead;
+}
+
+function formatDuration (ns)
+{
+    if (ns < 1e3)
+        return ns.toFixed(0) + " ns";
+    if (ns < 1e6)
+        return (ns / 1e3).toFixed(1) + " µs";
+    if (ns < 1e9)
+        return (ns / 1e6).toFixed(2) + " ms";
+    return (ns / 1e9).toFixed(2) + " s";
+}
+
+// Runs f warmup times, then until runs timed runs are done or budget
+// nanoseconds have been measured
+function measure (f, warmup, runs, budget)
+{
+    let overhead = measureClockOverhead();
+    let samples = [];
+    let total = 0;
+    let result;
+
+    for (let i = 0; i < warmup; i++)
+        result = f();
+
+    let gcs = __gcCount();
+    while (samples.length < runs && total < budget) {
+        let start = __clock();
+        result = f();
+        let elapsed = Math.max(0, __clock() - start - overhead);
+        samples.push(elapsed);
+        total += elapsed;
+    }
+    gcs = __gcCount() - gcs;
+
+    samples.sort(function(a, b) { return a - b; });
+    return { samples: samples, gcs: gcs, warmup: warmup, result: result };
+}
+
+function percentile (sorted, p)
+{
+    return sorted[Math.max(0, Math.ceil(p * sorted.length) - 1)];
+}
+
+function median (sorted)
+{
+    let mid = sorted.length >> 1;
+    if (sorted.length % 2)
+        return sorted[mid];
+    return (sorted[mid - 1] + sorted[mid]) / 2;
+}
+
+function reportTiming (m)
+{
+    let s = m.samples;
+    print (s.length + " runs after " + m.warmup + " warm-up: " +
+           "min " + formatDuration(s[0]) +
+           ", median " + formatDuration(median(s)) +
+           ", p95 " + formatDuration(percentile(s, 0.95)) +
+           ", max " + formatDuration(s[s.length - 1]) +
+           ", " + m.gcs + (m.gcs == 1 ? " GC" : " GCs"));
+}
+
+// %time expr: times expr for about TIME_BUDGET_NS
+// %bench [N] expr: times exactly N runs of expr
+function evalMagic (command, args)
+{
+    let m;
+
+    if (args.trim() == '')
+        throw new Error("usage: %time expr, %bench [N] expr");
+
+    if (command == 'time') {
+        m = measure(compileSnippet(args), 1, TIME_MAX_RUNS, TIME_BUDGET_NS);
+    } else {
+        let runs = DEFAULT_BENCH_RUNS;
+        let match = args.match(/^(\d+)\s+([^]*)$/);
+        if (match) {
+            runs = parseInt(match[1], 10);
+            args = match[2];
+        }
+        if (runs < 1)
+            throw new Error("%bench needs at least one run");
+        m = measure(compileSnippet(args), Math.max(1, Math.floor(runs / 10)), runs, Infinity);
+    }
+
+    reportTiming(m);
+    return m.result;
+}
+
+// The bindings user code is evaluated against.  This is built once
+// per session and used as the scope of every evaluation and
+// completion.  Modules are only imported when first
+// used, so creating it doesn't hold up the first prompt.
+function createScope ()
+{
+    let scope = {
+        r: getResult,
+        retained: retained,
+        startup: startup,
+        inspect: inspect,
+        frames: frames,
+        trace: trace,
+        changes: changes,
+        census: census,
+        watch: watch,
+        heap: heap,
+        gc: gc,
+        $$: function(selector, root) {
+            return root === undefined ? __query(selector) : __query(selector, root);
+        }
+    };
+    let modules = {
+        GLib: function() { return imports.gi.GLib; },
+        GObject: function() { return imports.gi.GObject; },
+        Gio: function() { return imports.gi.Gio; },
+        Pango: function() { return imports.gi.Pango; },
+        Cairo: function() { return imports.cairo; },
+        Gtk: function() { return imports.gi.Gtk; }
+    };
+    Object.keys(modules).forEach(function(name) {
+        Object.defineProperty(scope, name, { get: modules[name], enumerable: true });
+    });
+    // These used to be consts, so 'r = 1' at the prompt must not
+    // replace r for the rest of the session
+    return Object.freeze(scope);
+}
+
+// What a page keeps for itself.  Pages may share one context, and
+// so one global; interactive.cpp sets __session and __inspector to
+// those of the page before running anything for it.  Variables
+// assigned at top level still go to the shared global.
+function createSession (inspector)
+{
+    return {
+        inspector: inspector,
+        scope: createScope(),
+        results: [],
+        offset: 0,
+        dropped: 0,
+        collected: 0,
+        valueView: null
+    };
+}
 
 const JsParse = imports.inspector.jsParse;
+const ValueView = imports.inspector.valueView;
 
 function complete (text)
 {
-    let [completions, attrHead] = JsParse.getCompletions(text, commandHeader, null);
-    completions.sort();
-    if (completions.length == 0) {
-        __inspector.completion_label.hide ();
-        __inspector.completion_label.error_bell ();
-    } else if (completions.length == 1) {
+    let [completions, attrHead] = JsParse.getCompletions(text, __session.scope, null);
+    if (completions.length == 1) {
+        __hideCompletions();
         __inspector.entry.emit("insert_at_cursor", completions[0].slice(attrHead.length));
-        __inspector.completion_label.hide ();
-    } else {
+        return;
+    }
+
+    // The list is ranked natively and follows further typing by itself
+    let [candidates] = JsParse.getCandidates(text, __session.scope, null);
+    if (__showCompletions(candidates, text.length - attrHead.length) == 0) {
+        __inspector.entry.error_bell ();
+        return;
+    }
+    if (completions.length > 1) {
+        completions.sort();
         let commonPrefix = JsParse.getCommonPrefix(completions);
-        __inspector.completion_label.set_text(completions.join(", "));
-        __inspector.completion_label.show ();
         __inspector.entry.emit("insert_at_cursor", commonPrefix.slice(attrHead.length));
     }
 }
 
+// Returns false if text threw
 function evalLine (text)
 {
-    __inspector.completion_label.hide ();
+    JsParse.invalidateCompletions();
+    __hideCompletions();
     print ("» " + text);
     try {
-        let __r = eval (commandHeader + text);
-        print ("r(" + offset + ") = " + String(__r));
-        evalResults[offset++] = __r;
+        let __r;
+        let magic = text.match(/^\s*%(time|bench)\b\s*([^]*)$/);
+        if (magic)
+            __r = evalMagic(magic[1], magic[2]);
+        else
+            with (__session.scope)
+                __r = eval (text);
+        print ("r(" + __session.offset + ") = " + ValueView.summarize(__r));
+        let n = addResult(__r);
+        if (__r !== null && typeof __r === 'object')
+            ValueView.showValue("r(" + n + ")", n);
+        return true;
     }
     catch (e) {
-        print ("r(" + offset + ") = <exception " + String(e) + ">");
-        evalResults[offset++] = e;
+        print ("r(" + __session.offset + ") = <exception " + String(e) + ">");
+        addResult(e);
+        return false;
     }
 }
 
 function objectChanged (text)
 {
-    __inspector.completion_label.hide ();
+    JsParse.invalidateCompletions();
+    __hideCompletions();
     print ("» new object selected");
-    print ("r(" + offset + ") = " + String(__inspector.object));
-    evalResults[offset++] = __inspector.object;
+    print ("r(" + __session.offset + ") = " + ValueView.summarize(__inspector.object));
+    addResult(__inspector.object);
 }
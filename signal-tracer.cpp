@@ -0,0 +1,714 @@
+/*
+ * Copyright (c) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "signal-tracer.h"
+
+/* An emission hook on each traced signal writes a record when an
+ * emission starts. Where the signal returns nothing or a gboolean, an
+ * after handler is also connected to each instance the first time it
+ * emits, and writes a second record with the duration when the
+ * emission gets to it. Emissions stopped early never get there; their
+ * start stays on a small per-thread stack until pushed out.
+ *
+ * So a duration covers the handlers and any RUN_LAST class handler,
+ * but not a RUN_FIRST class handler, which runs before the hooks; for
+ * signals like GtkWidget::size-allocate most of the work is missed.
+ * Emissions a handler stops get no duration at all. The report says
+ * as much next to the figures.
+ *
+ * Records go into a ring allocated up front, on the main thread, before
+ * any hook can run. Writers claim a slot with an atomic increment, so
+ * signals emitted on other threads are recorded without locking. Each
+ * slot carries a sequence number which is zero while it is being
+ * written, so the reader can skip torn records.
+ *
+ * Everything else happens on the main thread. Instances first seen
+ * emitting on another thread are queued, under a lock, and get their
+ * after handler from an idle. The after handlers are listed with weak
+ * references to their instances, and disconnected when tracing stops
+ * or is cleared. */
+
+#define RING_SIZE (1 << 16)
+#define MAX_PENDING 64
+#define MAX_INSTANCES_LISTED 30
+#define RATE_WINDOW 10
+
+typedef struct
+{
+  volatile gint seq;      /* index + 1 once written */
+  gint32        duration; /* -1 for the start of an emission */
+  gint64        time;
+  gpointer      instance; /* never dereferenced, may be gone */
+  GType         type;
+  guint         signal_id;
+} TraceRecord;
+
+typedef struct
+{
+  guint       signal_id;
+  GQuark      connected;  /* set on instances with an after handler */
+  gboolean    timed;
+  gboolean    run_first;
+  gulong      hook_id;    /* changed on the main thread only */
+  GHashTable *queued;     /* instances waiting for the idle, under queue_lock */
+} TracedSignal;
+
+typedef struct
+{
+  GWeakRef      object;
+  gulong        handler;
+  TracedSignal *traced;
+} Connection;
+
+typedef struct
+{
+  GWeakRef      object;
+  TracedSignal *traced;
+} QueuedConnection;
+
+typedef struct
+{
+  gpointer instance;
+  guint    signal_id;
+  gint64   start;
+} PendingEmission;
+
+typedef struct
+{
+  guint           depth;
+  PendingEmission items[MAX_PENDING];
+} PendingStack;
+
+static TraceRecord *ring;
+static volatile gint ring_next;
+static guint ring_base;            /* first index after the last clear */
+static GHashTable *traced_signals; /* signal id -> TracedSignal, never freed */
+static GThread *main_thread;
+static GPrivate pending_key = G_PRIVATE_INIT (g_free);
+static GPtrArray *connections;     /* Connection */
+static GMutex queue_lock;
+static GPtrArray *queue;           /* QueuedConnection, from other threads */
+static guint queue_idle;
+
+static void
+ring_write (gint64   time,
+            gpointer instance,
+            guint    signal_id,
+            gint64   duration)
+{
+  guint index = (guint)g_atomic_int_add (&ring_next, 1);
+  TraceRecord *record = &ring[index % RING_SIZE];
+
+  g_atomic_int_set (&record->seq, 0);
+  record->time = time;
+  record->instance = instance;
+  record->type = G_TYPE_FROM_INSTANCE (instance);
+  record->signal_id = signal_id;
+  record->duration = (gint32)MIN (duration, G_MAXINT32);
+  g_atomic_int_set (&record->seq, (gint)(index + 1));
+}
+
+static void
+pending_push (gpointer instance,
+              guint    signal_id,
+              gint64   start)
+{
+  PendingStack *stack = (PendingStack *)g_private_get (&pending_key);
+
+  if (stack == NULL)
+    {
+      stack = g_new0 (PendingStack, 1);
+      g_private_set (&pending_key, stack);
+    }
+
+  /* Full of emissions that were stopped before our handler */
+  if (stack->depth == MAX_PENDING)
+    {
+      memmove (&stack->items[0], &stack->items[1], (MAX_PENDING - 1) * sizeof (PendingEmission));
+      stack->depth--;
+    }
+
+  stack->items[stack->depth].instance = instance;
+  stack->items[stack->depth].signal_id = signal_id;
+  stack->items[stack->depth].start = start;
+  stack->depth++;
+}
+
+static void
+emission_done (GClosure     *closure,
+               GValue       *return_value,
+               guint         n_param_values,
+               const GValue *param_values,
+               gpointer      invocation_hint,
+               gpointer      marshal_data)
+{
+  TracedSignal *traced = (TracedSignal *)closure->data;
+  gpointer instance = g_value_peek_pointer (&param_values[0]);
+  PendingStack *stack = (PendingStack *)g_private_get (&pending_key);
+  gint i;
+
+  /* return_value is left alone, so the result of the emission is
+   * whatever the handlers before this one made it */
+  if (stack == NULL)
+    return;
+
+  for (i = (gint)stack->depth - 1; i >= 0; i--)
+    {
+      PendingEmission *pending = &stack->items[i];
+
+      if (pending->instance == instance && pending->signal_id == traced->signal_id)
+        {
+          ring_write (pending->start, instance, traced->signal_id,
+                      g_get_monotonic_time () - pending->start);
+          /* Anything above was stopped early */
+          stack->depth = i;
+          return;
+        }
+    }
+}
+
+static void
+connection_add (GObject      *object,
+                gulong        handler,
+                TracedSignal *traced)
+{
+  Connection *connection;
+
+  connection = g_new0 (Connection, 1);
+  g_weak_ref_init (&connection->object, object);
+  connection->handler = handler;
+  connection->traced = traced;
+
+  g_ptr_array_add (connections, connection);
+}
+
+static void
+disconnect_all (void)
+{
+  guint i;
+
+  for (i = 0; i < connections->len; i++)
+    {
+      Connection *connection = (Connection *)connections->pdata[i];
+      GObject *object = (GObject *)g_weak_ref_get (&connection->object);
+
+      /* A finalized object took its handler with it */
+      if (object)
+        {
+          g_signal_handler_disconnect (object, connection->handler);
+          g_object_set_qdata (object, connection->traced->connected, NULL);
+          g_object_unref (object);
+        }
+      g_weak_ref_clear (&connection->object);
+      g_free (connection);
+    }
+
+  g_ptr_array_set_size (connections, 0);
+}
+
+/* Called on the main thread, the first time instance emits there or
+ * from the idle */
+static void
+connect_instance (GObject      *object,
+                  TracedSignal *traced)
+{
+  GClosure *closure;
+  gulong handler;
+
+  if (g_object_get_qdata (object, traced->connected) != NULL)
+    return;
+
+  /* Handlers connected during an emission don't run in it, so this
+   * one is timed from the next emission on */
+  closure = g_closure_new_simple (sizeof (GClosure), traced);
+  g_closure_set_marshal (closure, emission_done);
+  handler = g_signal_connect_closure_by_id (object, traced->signal_id, 0, closure, TRUE);
+  g_object_set_qdata (object, traced->connected, GINT_TO_POINTER (1));
+  connection_add (object, handler, traced);
+}
+
+static gboolean
+connect_queued (gpointer data)
+{
+  GPtrArray *queued;
+  guint i;
+
+  g_mutex_lock (&queue_lock);
+  queued = queue;
+  queue = g_ptr_array_new ();
+  queue_idle = 0;
+  for (i = 0; i < queued->len; i++)
+    g_hash_table_remove_all (((QueuedConnection *)queued->pdata[i])->traced->queued);
+  g_mutex_unlock (&queue_lock);
+
+  for (i = 0; i < queued->len; i++)
+    {
+      QueuedConnection *entry = (QueuedConnection *)queued->pdata[i];
+      GObject *object = (GObject *)g_weak_ref_get (&entry->object);
+
+      /* Tracing may have stopped since */
+      if (object)
+        {
+          if (entry->traced->hook_id != 0)
+            connect_instance (object, entry->traced);
+          g_object_unref (object);
+        }
+      g_weak_ref_clear (&entry->object);
+      g_free (entry);
+    }
+
+  g_ptr_array_unref (queued);
+
+  return G_SOURCE_REMOVE;
+}
+
+/* Called on other threads; the instance is alive for the emission */
+static void
+queue_instance (GObject      *object,
+                TracedSignal *traced)
+{
+  QueuedConnection *entry;
+
+  g_mutex_lock (&queue_lock);
+  if (!g_hash_table_contains (traced->queued, object))
+    {
+      entry = g_new0 (QueuedConnection, 1);
+      g_weak_ref_init (&entry->object, object);
+      entry->traced = traced;
+      g_hash_table_add (traced->queued, object);
+      g_ptr_array_add (queue, entry);
+
+      if (queue_idle == 0)
+        queue_idle = g_idle_add (connect_queued, NULL);
+    }
+  g_mutex_unlock (&queue_lock);
+}
+
+static gboolean
+emission_hook (GSignalInvocationHint *ihint,
+               guint                  n_param_values,
+               const GValue          *param_values,
+               gpointer               data)
+{
+  TracedSignal *traced = (TracedSignal *)data;
+  gpointer instance = g_value_peek_pointer (&param_values[0]);
+  gint64 now = g_get_monotonic_time ();
+
+  ring_write (now, instance, ihint->signal_id, -1);
+
+  if (traced->timed && G_IS_OBJECT (instance))
+    {
+      /* The flag is only set on the main thread, after connecting */
+      if (g_object_get_qdata (G_OBJECT (instance), traced->connected) != NULL)
+        pending_push (instance, ihint->signal_id, now);
+      else if (g_thread_self () == main_thread)
+        connect_instance (G_OBJECT (instance), traced);
+      else
+        queue_instance (G_OBJECT (instance), traced);
+    }
+
+  return TRUE;
+}
+
+void
+gtk_inspector_signal_tracer_init (void)
+{
+  if (ring != NULL)
+    return;
+
+  /* Left untouched, the pages of the ring cost nothing */
+  ring = g_new0 (TraceRecord, RING_SIZE);
+  traced_signals = g_hash_table_new (NULL, NULL);
+  connections = g_ptr_array_new ();
+  queue = g_ptr_array_new ();
+  main_thread = g_thread_self ();
+}
+
+gboolean
+gtk_inspector_signal_tracer_add (guint signal_id)
+{
+  TracedSignal *traced;
+  GSignalQuery query;
+
+  g_signal_query (signal_id, &query);
+  if (query.signal_id == 0 || (query.signal_flags & G_SIGNAL_NO_HOOKS) != 0)
+    return FALSE;
+
+  traced = (TracedSignal *)g_hash_table_lookup (traced_signals, GUINT_TO_POINTER (signal_id));
+  if (traced == NULL)
+    {
+      GType return_type = query.return_type & ~G_SIGNAL_TYPE_STATIC_SCOPE;
+      gchar *name;
+
+      traced = g_new0 (TracedSignal, 1);
+      traced->signal_id = signal_id;
+      /* An after handler can only stay out of the way of the return
+       * value when nothing is returned, or FALSE means "not handled" */
+      traced->timed = return_type == G_TYPE_NONE || return_type == G_TYPE_BOOLEAN;
+      traced->run_first = (query.signal_flags & G_SIGNAL_RUN_FIRST) != 0;
+      traced->queued = g_hash_table_new (NULL, NULL);
+      name = g_strdup_printf ("gtk-inspector-signal-tracer-%u", signal_id);
+      traced->connected = g_quark_from_string (name);
+      g_free (name);
+
+      g_hash_table_insert (traced_signals, GUINT_TO_POINTER (signal_id), traced);
+    }
+
+  if (traced->hook_id == 0)
+    traced->hook_id = g_signal_add_emission_hook (signal_id, 0, emission_hook, traced, NULL);
+
+  return TRUE;
+}
+
+void
+gtk_inspector_signal_tracer_stop (void)
+{
+  GHashTableIter iter;
+  gpointer value;
+
+  g_hash_table_iter_init (&iter, traced_signals);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      TracedSignal *traced = (TracedSignal *)value;
+
+      if (traced->hook_id != 0)
+        {
+          g_signal_remove_emission_hook (traced->signal_id, traced->hook_id);
+          traced->hook_id = 0;
+        }
+    }
+
+  disconnect_all ();
+}
+
+/* Instances still traced get a new after handler when they next emit */
+void
+gtk_inspector_signal_tracer_clear (void)
+{
+  ring_base = (guint)g_atomic_int_get (&ring_next);
+  disconnect_all ();
+}
+
+/* Copies the records written since the last clear that are still in
+ * the ring, oldest first */
+static GArray *
+snapshot (guint *n_written)
+{
+  GArray *records;
+  guint next, first, i;
+
+  next = (guint)g_atomic_int_get (&ring_next);
+  *n_written = next - ring_base;
+  first = *n_written > RING_SIZE ? next - RING_SIZE : ring_base;
+
+  records = g_array_sized_new (FALSE, FALSE, sizeof (TraceRecord), next - first);
+  for (i = first; i != next; i++)
+    {
+      TraceRecord *slot = &ring[i % RING_SIZE];
+      TraceRecord copy;
+
+      if (g_atomic_int_get (&slot->seq) != (gint)(i + 1))
+        continue;
+      copy = *slot;
+      if (g_atomic_int_get (&slot->seq) != (gint)(i + 1))
+        continue;
+
+      g_array_append_val (records, copy);
+    }
+
+  return records;
+}
+
+static gchar *
+signal_name (guint signal_id)
+{
+  GSignalQuery query;
+
+  g_signal_query (signal_id, &query);
+  return g_strdup_printf ("%s::%s", g_type_name (query.itype), query.signal_name);
+}
+
+typedef struct
+{
+  gpointer    key;
+  GType       type;
+  guint       emissions;
+  guint       timed;
+  gint64      total;
+  gint32      max;
+  guint       recent[RATE_WINDOW];
+  GHashTable *signals;     /* signal id -> count, for instances */
+} Stats;
+
+static void
+stats_free (gpointer data)
+{
+  Stats *stats = (Stats *)data;
+
+  if (stats->signals)
+    g_hash_table_unref (stats->signals);
+  g_free (stats);
+}
+
+static Stats *
+stats_lookup (GHashTable *table,
+              gpointer    key)
+{
+  Stats *stats = (Stats *)g_hash_table_lookup (table, key);
+
+  if (stats == NULL)
+    {
+      stats = g_new0 (Stats, 1);
+      stats->key = key;
+      g_hash_table_insert (table, key, stats);
+    }
+
+  return stats;
+}
+
+static gint
+compare_by_emissions (gconstpointer a,
+                      gconstpointer b)
+{
+  const Stats *sa = *(const Stats **)a;
+  const Stats *sb = *(const Stats **)b;
+
+  return (sb->emissions > sa->emissions) - (sb->emissions < sa->emissions);
+}
+
+static gint
+compare_by_rate (gconstpointer a,
+                 gconstpointer b)
+{
+  const Stats *sa = *(const Stats **)a;
+  const Stats *sb = *(const Stats **)b;
+
+  if (sa->recent[0] != sb->recent[0])
+    return (sb->recent[0] > sa->recent[0]) - (sb->recent[0] < sa->recent[0]);
+
+  return compare_by_emissions (a, b);
+}
+
+static GPtrArray *
+sorted_stats (GHashTable   *table,
+              GCompareFunc  compare)
+{
+  GPtrArray *sorted = g_ptr_array_sized_new (g_hash_table_size (table));
+  GHashTableIter iter;
+  gpointer value;
+
+  g_hash_table_iter_init (&iter, table);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    g_ptr_array_add (sorted, value);
+  g_ptr_array_sort (sorted, compare);
+
+  return sorted;
+}
+
+static void
+report_by_signal (GString *report,
+                  GArray  *records)
+{
+  GHashTable *table = g_hash_table_new_full (NULL, NULL, NULL, stats_free);
+  GPtrArray *sorted;
+  guint i;
+
+  for (i = 0; i < records->len; i++)
+    {
+      const TraceRecord *record = &g_array_index (records, TraceRecord, i);
+      Stats *stats = stats_lookup (table, GUINT_TO_POINTER (record->signal_id));
+
+      if (record->duration < 0)
+        {
+          stats->emissions++;
+        }
+      else
+        {
+          stats->timed++;
+          stats->total += record->duration;
+          stats->max = MAX (stats->max, record->duration);
+        }
+    }
+
+  sorted = sorted_stats (table, compare_by_emissions);
+  for (i = 0; i < sorted->len; i++)
+    {
+      Stats *stats = (Stats *)sorted->pdata[i];
+      TracedSignal *traced = (TracedSignal *)g_hash_table_lookup (traced_signals, stats->key);
+      gchar *name = signal_name (GPOINTER_TO_UINT (stats->key));
+
+      g_string_append_printf (report, "\n  %-40s %8u", name, stats->emissions);
+      if (stats->timed > 0)
+        g_string_append_printf (report, "  %u timed, mean %.1f µs, max %.1f ms, total %.1f ms%s",
+                                stats->timed,
+                                (double)stats->total / stats->timed,
+                                stats->max / 1000.0,
+                                stats->total / 1000.0,
+                                traced != NULL && traced->run_first ? ", class handler not included" : "");
+      g_free (name);
+    }
+
+  g_ptr_array_unref (sorted);
+  g_hash_table_unref (table);
+}
+
+static void
+report_by_instance (GString *report,
+                    GArray  *records)
+{
+  GHashTable *table = g_hash_table_new_full (NULL, NULL, NULL, stats_free);
+  GPtrArray *sorted;
+  guint i;
+
+  for (i = 0; i < records->len; i++)
+    {
+      const TraceRecord *record = &g_array_index (records, TraceRecord, i);
+      Stats *stats;
+      gpointer key = GUINT_TO_POINTER (record->signal_id);
+
+      if (record->duration >= 0)
+        continue;
+
+      stats = stats_lookup (table, record->instance);
+      stats->type = record->type;
+      stats->emissions++;
+      if (stats->signals == NULL)
+        stats->signals = g_hash_table_new (NULL, NULL);
+      g_hash_table_insert (stats->signals, key,
+                           GUINT_TO_POINTER (GPOINTER_TO_UINT (g_hash_table_lookup (stats->signals, key)) + 1));
+    }
+
+  sorted = sorted_stats (table, compare_by_emissions);
+  for (i = 0; i < sorted->len && i < MAX_INSTANCES_LISTED; i++)
+    {
+      Stats *stats = (Stats *)sorted->pdata[i];
+      GHashTableIter iter;
+      gpointer key, value;
+      guint top_signal = 0, top_count = 0;
+      gchar *name;
+
+      g_hash_table_iter_init (&iter, stats->signals);
+      while (g_hash_table_iter_next (&iter, &key, &value))
+        if (GPOINTER_TO_UINT (value) > top_count)
+          {
+            top_signal = GPOINTER_TO_UINT (key);
+            top_count = GPOINTER_TO_UINT (value);
+          }
+
+      name = signal_name (top_signal);
+      g_string_append_printf (report, "\n  %s %p  %8u, most often %s (%u)",
+                              g_type_name (stats->type), stats->key,
+                              stats->emissions, name, top_count);
+      g_free (name);
+    }
+  if (sorted->len > MAX_INSTANCES_LISTED)
+    g_string_append_printf (report, "\n  and %u more instances", sorted->len - MAX_INSTANCES_LISTED);
+
+  g_ptr_array_unref (sorted);
+  g_hash_table_unref (table);
+}
+
+static void
+report_rate (GString *report,
+             GArray  *records)
+{
+  GHashTable *table = g_hash_table_new_full (NULL, NULL, NULL, stats_free);
+  gint64 now = g_get_monotonic_time ();
+  GPtrArray *sorted;
+  guint i, j;
+
+  for (i = 0; i < records->len; i++)
+    {
+      const TraceRecord *record = &g_array_index (records, TraceRecord, i);
+      gint64 age = (now - record->time) / G_USEC_PER_SEC;
+      Stats *stats;
+
+      if (record->duration >= 0 || age >= RATE_WINDOW)
+        continue;
+
+      stats = stats_lookup (table, GUINT_TO_POINTER (record->signal_id));
+      stats->emissions++;
+      stats->recent[age]++;
+    }
+
+  g_string_append_printf (report, "\n  %-40s %8s %8s %8s", "per second:", "last", "mean", "peak");
+
+  sorted = sorted_stats (table, compare_by_rate);
+  for (i = 0; i < sorted->len; i++)
+    {
+      Stats *stats = (Stats *)sorted->pdata[i];
+      gchar *name = signal_name (GPOINTER_TO_UINT (stats->key));
+      guint peak = 0;
+
+      for (j = 0; j < RATE_WINDOW; j++)
+        peak = MAX (peak, stats->recent[j]);
+
+      g_string_append_printf (report, "\n  %-40s %8u %8.1f %8u",
+                              name, stats->recent[0],
+                              (double)stats->emissions / RATE_WINDOW, peak);
+      g_free (name);
+    }
+
+  g_ptr_array_unref (sorted);
+  g_hash_table_unref (table);
+}
+
+gchar *
+gtk_inspector_signal_tracer_report (GtkInspectorSignalReport kind)
+{
+  GString *report;
+  GArray *records;
+  guint n_written;
+
+  if (g_hash_table_size (traced_signals) == 0)
+    return g_strdup ("No signals traced");
+
+  records = snapshot (&n_written);
+  report = g_string_new (NULL);
+
+  g_string_append_printf (report, "%u records", n_written);
+  if (n_written > RING_SIZE)
+    g_string_append_printf (report, ", the last %u kept", RING_SIZE);
+
+  switch (kind)
+    {
+    case GTK_INSPECTOR_SIGNAL_REPORT_BY_SIGNAL:
+      g_string_append (report, "; durations leave out RUN_FIRST class handlers, "
+                       "and are missing where a handler stopped the emission");
+      report_by_signal (report, records);
+      break;
+    case GTK_INSPECTOR_SIGNAL_REPORT_BY_INSTANCE:
+      report_by_instance (report, records);
+      break;
+    case GTK_INSPECTOR_SIGNAL_REPORT_RATE:
+      g_string_append_printf (report, ", over the last %d seconds", RATE_WINDOW);
+      report_rate (report, records);
+      break;
+    default:
+      g_assert_not_reached ();
+    }
+
+  g_array_unref (records);
+
+  return g_string_free (report, FALSE);
+}
+
+// vim: set et sw=2 ts=2:
@@ -0,0 +1,55 @@
+/*
+ * Copyright (c) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _GTK_INSPECTOR_SIGNAL_TRACER_H_
+#define _GTK_INSPECTOR_SIGNAL_TRACER_H_
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+typedef enum {
+  GTK_INSPECTOR_SIGNAL_REPORT_BY_SIGNAL,
+  GTK_INSPECTOR_SIGNAL_REPORT_BY_INSTANCE,
+  GTK_INSPECTOR_SIGNAL_REPORT_RATE
+} GtkInspectorSignalReport;
+
+/* The tracer is process wide, since emission hooks are. These must be
+ * called from the main thread; emissions may happen on any thread. */
+
+/* Sets up the ring; must come first, before anything else is called */
+void
+gtk_inspector_signal_tracer_init (void);
+
+/* Starts tracing signal_id, returns FALSE if it can't be hooked */
+gboolean
+gtk_inspector_signal_tracer_add (guint signal_id);
+
+void
+gtk_inspector_signal_tracer_stop (void);
+
+void
+gtk_inspector_signal_tracer_clear (void);
+
+gchar *
+gtk_inspector_signal_tracer_report (GtkInspectorSignalReport report);
+
+G_END_DECLS
+
+#endif // _GTK_INSPECTOR_SIGNAL_TRACER_H_
+
+// vim: set et sw=2 ts=2:
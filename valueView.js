@@ -0,0 +1,285 @@
+/* -*- mode: js2; js2-basic-offset: 4; indent-tabs-mode: nil -*- */
+
+const GObject = imports.gi.GObject;
+
+// Shows a value as a tree in __inspector.value_view.  The children of a
+// row are only looked at when it is expanded, and then only a page at a
+// time, so showing a 1M item list model costs the same as a small one.
+
+const PAGE_SIZE = 100;
+const MAX_SUMMARY = 200;
+
+const COLUMN_NAME = 0;
+const COLUMN_VALUE = 1;
+const COLUMN_NODE = 2;
+
+// Each page's view has its own state, kept in the page's session:
+// rows with children refer to a node in state.nodes, and rows that
+// load the next page of their siblings to one with a 'more' field.
+// Nodes don't hold values, which would keep them alive after the
+// result they came from has been dropped.  The shown result is found
+// again by its index, and a child by its position under its parent.
+
+function isGObject (value) {
+    return value instanceof GObject.Object;
+}
+
+function isListModel (value) {
+    return isGObject(value) &&
+        typeof value.get_n_items === 'function' &&
+        typeof value.get_item === 'function';
+}
+
+function truncate (str) {
+    if (str.length > MAX_SUMMARY)
+        return str.slice(0, MAX_SUMMARY) + '…';
+    return str;
+}
+
+// A one line description of value that doesn't walk its contents,
+// unlike String() on an array
+function summarize (value) {
+    if (value === null || value === undefined)
+        return String(value);
+
+    switch (typeof value) {
+    case 'string':
+        return truncate(JSON.stringify(value));
+    case 'function':
+        return 'function ' + (value.name || '') + '()';
+    case 'object':
+        break;
+    default:
+        return String(value);
+    }
+
+    if (Array.isArray(value))
+        return 'Array(' + value.length + ')';
+
+    try {
+        if (isListModel(value))
+            return truncate(String(value)) + ' (' + value.get_n_items() + ' items)';
+        return truncate(String(value));
+    } catch (e) {
+        return '<exception ' + String(e) + '>';
+    }
+}
+
+function readProperty (obj, name) {
+    try {
+        return obj[name];
+    } catch (e) {
+        return e;
+    }
+}
+
+// Thrown when the child a row stands for is no longer there, because
+// its parent changed since the row was added
+function Changed () {
+}
+
+Changed.prototype.toString = function() {
+    return 'changed, re-expand';
+};
+
+// Returns { length, get(i) -> [name, value], key(i, value), lookup(key) }
+// for the children of value.  A key identifies a child without holding
+// it; lookup finds the child again, or throws Changed if it's gone.
+function childSource (value) {
+    if (Array.isArray(value)) {
+        let length = value.length;
+        return { length: length,
+                 get: function(i) { return [String(i), value[i]]; },
+                 key: function(i) { return { index: i, length: length }; },
+                 lookup: function(key) {
+                     if (value.length !== key.length)
+                         throw new Changed();
+                     return value[key.index];
+                 } };
+    }
+
+    if (isListModel(value)) {
+        let length = value.get_n_items();
+        return { length: length,
+                 get: function(i) { return ['[' + i + ']', value.get_item(i)]; },
+                 // Items are GObjects, which can be held weakly
+                 key: function(i, item) {
+                     return { index: i, length: length, handle: __weakRef(item) };
+                 },
+                 lookup: function(key) {
+                     if (value.get_n_items() !== key.length)
+                         throw new Changed();
+                     let item = value.get_item(key.index);
+                     if (key.handle !== null && __weakGet(key.handle) !== item)
+                         throw new Changed();
+                     return item;
+                 } };
+    }
+
+    if (isGObject(value)) {
+        let props = __objectProperties(value);
+        return { length: props.length,
+                 get: function(i) {
+                     return [props[i], readProperty(value, props[i].replace(/-/g, '_'))];
+                 },
+                 key: function(i) { return { name: props[i] }; },
+                 lookup: function(key) {
+                     if (props.indexOf(key.name) < 0)
+                         throw new Changed();
+                     return readProperty(value, key.name.replace(/-/g, '_'));
+                 } };
+    }
+
+    let names = Object.getOwnPropertyNames(value);
+    return { length: names.length,
+             get: function(i) { return [names[i], readProperty(value, names[i])]; },
+             key: function(i) { return { name: names[i] }; },
+             lookup: function(key) {
+                 if (!Object.prototype.hasOwnProperty.call(value, key.name))
+                     throw new Changed();
+                 return readProperty(value, key.name);
+             } };
+}
+
+// Throws if the result has been dropped or collected since, or Changed
+// if the value of the node is no longer where it was found
+function resolve (record) {
+    if (record.parent === null)
+        return imports.inspector.repl.getResult(record.result);
+
+    return childSource(resolve(record.parent)).lookup(record.key);
+}
+
+// record is the node of the row if value has children
+function addRow (state, store, parent, name, value, record) {
+    let iter = store.append(parent);
+    let node = 0;
+
+    if (value !== null && typeof value === 'object') {
+        node = state.nextNode++;
+        state.nodes[node] = record;
+        // Placeholder, so the row can be expanded
+        store.append(iter);
+    }
+
+    store.set_value(iter, COLUMN_NAME, name);
+    store.set_value(iter, COLUMN_VALUE, summarize(value));
+    store.set_value(iter, COLUMN_NODE, node);
+    return iter;
+}
+
+function addNote (store, parent, name, text) {
+    let iter = store.append(parent);
+
+    store.set_value(iter, COLUMN_NAME, name);
+    store.set_value(iter, COLUMN_VALUE, text);
+    store.set_value(iter, COLUMN_NODE, 0);
+}
+
+// Adds the children of record from start, or why they can't be had.
+// Later pages must come from a parent with as many children as the
+// first, or they wouldn't follow on from it.
+function addPage (state, store, parent, record, start, length) {
+    let source;
+
+    try {
+        source = childSource(resolve(record));
+    } catch (e) {
+        addNote(store, parent, e instanceof Changed ? '<changed>' : '<exception>', String(e));
+        return;
+    }
+
+    if (length !== undefined && source.length !== length) {
+        addNote(store, parent, '<changed>', String(new Changed()));
+        return;
+    }
+
+    let end = Math.min(start + PAGE_SIZE, source.length);
+
+    for (let i = start; i < end; i++) {
+        let [name, value] = source.get(i);
+        addRow(state, store, parent, name, value,
+               { parent: record, key: source.key(i, value), expanded: false });
+    }
+
+    if (end < source.length) {
+        let iter = store.append(parent);
+        let node = state.nextNode++;
+        state.nodes[node] = { more: record, start: end, length: source.length };
+        store.set_value(iter, COLUMN_NAME, '…');
+        store.set_value(iter, COLUMN_VALUE, (source.length - end) + ' more');
+        store.set_value(iter, COLUMN_NODE, node);
+    }
+}
+
+function onTestExpandRow (state, view, iter) {
+    let store = view.get_model();
+    let record = state.nodes[store.get_value(iter, COLUMN_NODE)];
+
+    if (record && !record.more && !record.expanded) {
+        let [ok, placeholder] = store.iter_children(iter);
+        if (ok)
+            store.remove(placeholder);
+
+        record.expanded = true;
+        addPage(state, store, iter, record, 0);
+    }
+
+    return false;
+}
+
+function onRowActivated (state, view, path) {
+    let store = view.get_model();
+    let [ok, iter] = store.get_iter(path);
+    if (!ok)
+        return;
+
+    let node = store.get_value(iter, COLUMN_NODE);
+    let record = state.nodes[node];
+    if (!record || !record.more)
+        return;
+
+    let [hasParent, parent] = store.iter_parent(iter);
+    store.remove(iter);
+    delete state.nodes[node];
+    addPage(state, store, hasParent ? parent : null, record.more, record.start, record.length);
+}
+
+// The state of the view of the current session, connected to the view
+// the first time.  The handlers run on their own, after any page may
+// have run, so they switch to the session of their view first.
+function viewState () {
+    if (__session.valueView)
+        return __session.valueView;
+
+    let session = __session;
+    let state = { nodes: {}, nextNode: 1 };
+    let view = __inspector.value_view;
+
+    view.connect('test-expand-row', function(view, iter, path) {
+        __useSession(session);
+        return onTestExpandRow(state, view, iter);
+    });
+    view.connect('row-activated', function(view, path, column) {
+        __useSession(session);
+        onRowActivated(state, view, path);
+    });
+
+    session.valueView = state;
+    return state;
+}
+
+// Shows result n, as returned by addResult in repl.js
+function showValue (name, n) {
+    let state = viewState();
+    let view = __inspector.value_view;
+    let store = view.get_model();
+
+    store.clear();
+    state.nodes = {};
+    addRow(state, store, null, name, imports.inspector.repl.getResult(n),
+           { parent: null, result: n, expanded: false });
+
+    view.get_parent().show();
+    view.expand_row(store.get_path(store.get_iter_first()[1]), false);
+}
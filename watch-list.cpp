@@ -0,0 +1,351 @@
+/*
+ * Copyright (c) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "watch-list.h"
+#include "handler-list.h"
+
+/* Each watch listens to ::notify on the GObjects its last evaluation
+ * reached. A notification only marks the watch stale and asks the
+ * frame clock for a tick, in which the stale watches are evaluated,
+ * so a burst of notifications costs at most one evaluation per frame
+ * and nothing runs while nothing changes. A page that is never shown,
+ * such as one serving a socket, has no frame clock, and its watches
+ * are evaluated at idle instead. Notifications sent while a watch is
+ * being evaluated are its own doing, and are ignored by that watch;
+ * other watches still see them. */
+
+typedef struct
+{
+  GtkInspectorWatchList *list;
+  guint     id;
+  gchar    *expression;
+  gchar    *value;
+  GtkInspectorHandlerList *handlers;
+  gboolean  stale;
+  guint     evaluations;
+  gint64    last_cost;      /* microseconds */
+  gint64    total_cost;
+} Watch;
+
+struct _GtkInspectorWatchList
+{
+  GtkWidget             *widget;
+  GtkListStore          *store;
+  GtkInspectorWatchFunc  func;
+  gpointer               data;
+
+  GPtrArray *watches;       /* Watch, in the order of the rows */
+  guint      next_id;
+  guint      tick_id;
+  guint      idle_id;       /* instead of a tick, without a frame clock */
+  Watch     *evaluating;
+};
+
+static void
+watch_free (gpointer data)
+{
+  Watch *watch = (Watch *)data;
+
+  gtk_inspector_handler_list_free (watch->handlers);
+  g_free (watch->expression);
+  g_free (watch->value);
+  g_free (watch);
+}
+
+static gint
+find_watch (GtkInspectorWatchList *list,
+            guint                  id)
+{
+  guint i;
+
+  for (i = 0; i < list->watches->len; i++)
+    if (((Watch *)g_ptr_array_index (list->watches, i))->id == id)
+      return i;
+
+  return -1;
+}
+
+static void
+evaluate_stale (GtkInspectorWatchList *list)
+{
+  GArray *stale;
+  guint i;
+
+  /* Evaluating may add and remove watches, so go by id */
+  stale = g_array_new (FALSE, FALSE, sizeof (guint));
+  for (i = 0; i < list->watches->len; i++)
+    {
+      Watch *watch = (Watch *)g_ptr_array_index (list->watches, i);
+
+      if (watch->stale)
+        g_array_append_val (stale, watch->id);
+    }
+
+  for (i = 0; i < stale->len; i++)
+    {
+      gint pos = find_watch (list, g_array_index (stale, guint, i));
+      Watch *watch;
+
+      if (pos < 0)
+        continue;
+
+      watch = (Watch *)g_ptr_array_index (list->watches, pos);
+      watch->stale = FALSE;
+
+      list->evaluating = watch;
+      list->func (list, watch->id, watch->expression, list->data);
+      list->evaluating = NULL;
+    }
+
+  g_array_unref (stale);
+}
+
+static gboolean
+tick (GtkWidget     *widget,
+      GdkFrameClock *clock,
+      gpointer       data)
+{
+  GtkInspectorWatchList *list = (GtkInspectorWatchList *)data;
+
+  list->tick_id = 0;
+  evaluate_stale (list);
+
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean
+idle (gpointer data)
+{
+  GtkInspectorWatchList *list = (GtkInspectorWatchList *)data;
+
+  list->idle_id = 0;
+  evaluate_stale (list);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+mark_stale (Watch *watch)
+{
+  GtkInspectorWatchList *list = watch->list;
+
+  watch->stale = TRUE;
+
+  /* A tick asked for before the widget was unrealized never comes */
+  if (gtk_widget_get_frame_clock (list->widget) == NULL)
+    {
+      if (list->tick_id)
+        {
+          gtk_widget_remove_tick_callback (list->widget, list->tick_id);
+          list->tick_id = 0;
+        }
+      if (list->idle_id == 0)
+        list->idle_id = g_idle_add (idle, list);
+    }
+  else if (list->tick_id == 0 && list->idle_id == 0)
+    {
+      list->tick_id = gtk_widget_add_tick_callback (list->widget, tick, list, NULL);
+    }
+}
+
+static void
+object_notify (GObject    *object,
+               GParamSpec *pspec,
+               Watch      *watch)
+{
+  if (watch->list->evaluating == watch || watch->stale)
+    return;
+
+  mark_stale (watch);
+}
+
+static void
+update_row (GtkInspectorWatchList *list,
+            guint                  pos)
+{
+  Watch *watch = (Watch *)g_ptr_array_index (list->watches, pos);
+  guint n_objects = gtk_inspector_handler_list_get_length (watch->handlers);
+  GtkTreeIter iter;
+  gchar *cost;
+
+  if (watch->evaluations == 0)
+    cost = g_strdup ("");
+  else
+    cost = g_strdup_printf ("%.2f ms, %u %s, %u %s",
+                            watch->last_cost / 1000.0,
+                            n_objects,
+                            n_objects == 1 ? "object" : "objects",
+                            watch->evaluations,
+                            watch->evaluations == 1 ? "run" : "runs");
+
+  gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (list->store), &iter, NULL, pos);
+  gtk_list_store_set (list->store, &iter,
+                      GTK_INSPECTOR_WATCH_COLUMN_EXPRESSION, watch->expression,
+                      GTK_INSPECTOR_WATCH_COLUMN_VALUE, watch->value ? watch->value : "…",
+                      GTK_INSPECTOR_WATCH_COLUMN_COST, cost,
+                      -1);
+
+  g_free (cost);
+}
+
+GtkInspectorWatchList *
+gtk_inspector_watch_list_new (GtkWidget             *widget,
+                              GtkListStore          *store,
+                              GtkInspectorWatchFunc  func,
+                              gpointer               data)
+{
+  GtkInspectorWatchList *list;
+
+  list = g_new0 (GtkInspectorWatchList, 1);
+  list->widget = widget;
+  list->store = (GtkListStore *)g_object_ref (store);
+  list->func = func;
+  list->data = data;
+  list->watches = g_ptr_array_new_with_free_func (watch_free);
+  list->next_id = 1;
+
+  return list;
+}
+
+void
+gtk_inspector_watch_list_free (GtkInspectorWatchList *list)
+{
+  if (list->tick_id)
+    gtk_widget_remove_tick_callback (list->widget, list->tick_id);
+  if (list->idle_id)
+    g_source_remove (list->idle_id);
+  g_ptr_array_unref (list->watches);
+  g_object_unref (list->store);
+  g_free (list);
+}
+
+guint
+gtk_inspector_watch_list_add (GtkInspectorWatchList *list,
+                              const gchar           *expression)
+{
+  Watch *watch;
+  GtkTreeIter iter;
+
+  watch = g_new0 (Watch, 1);
+  watch->list = list;
+  watch->id = list->next_id++;
+  watch->expression = g_strdup (expression);
+  watch->handlers = gtk_inspector_handler_list_new ();
+  g_ptr_array_add (list->watches, watch);
+
+  gtk_list_store_append (list->store, &iter);
+  update_row (list, list->watches->len - 1);
+
+  mark_stale (watch);
+
+  return watch->id;
+}
+
+gboolean
+gtk_inspector_watch_list_remove (GtkInspectorWatchList *list,
+                                 guint                  id)
+{
+  GtkTreeIter iter;
+  gint pos;
+
+  pos = find_watch (list, id);
+  if (pos < 0)
+    return FALSE;
+
+  gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (list->store), &iter, NULL, pos);
+  gtk_list_store_remove (list->store, &iter);
+  g_ptr_array_remove_index (list->watches, pos);
+
+  return TRUE;
+}
+
+void
+gtk_inspector_watch_list_clear (GtkInspectorWatchList *list)
+{
+  gtk_list_store_clear (list->store);
+  g_ptr_array_set_size (list->watches, 0);
+}
+
+guint
+gtk_inspector_watch_list_get_n_watches (GtkInspectorWatchList *list)
+{
+  return list->watches->len;
+}
+
+void
+gtk_inspector_watch_list_set_result (GtkInspectorWatchList *list,
+                                     guint                  id,
+                                     const gchar           *value,
+                                     gint64                 cost,
+                                     GPtrArray             *objects)
+{
+  Watch *watch;
+  gint pos;
+  guint i;
+
+  pos = find_watch (list, id);
+  if (pos < 0)
+    return;
+
+  watch = (Watch *)g_ptr_array_index (list->watches, pos);
+
+  g_free (watch->value);
+  watch->value = g_strdup (value);
+  watch->evaluations++;
+  watch->last_cost = cost;
+  watch->total_cost += cost;
+
+  gtk_inspector_handler_list_disconnect_all (watch->handlers);
+  for (i = 0; objects != NULL && i < objects->len; i++)
+    gtk_inspector_handler_list_add (watch->handlers, G_OBJECT (objects->pdata[i]),
+                                    g_signal_connect (objects->pdata[i], "notify",
+                                                      G_CALLBACK (object_notify), watch));
+
+  update_row (list, pos);
+}
+
+gchar *
+gtk_inspector_watch_list_report (GtkInspectorWatchList *list)
+{
+  GString *report;
+  guint i;
+
+  report = g_string_new (NULL);
+  g_string_append_printf (report, "%u %s",
+                          list->watches->len,
+                          list->watches->len == 1 ? "watch" : "watches");
+
+  for (i = 0; i < list->watches->len; i++)
+    {
+      Watch *watch = (Watch *)g_ptr_array_index (list->watches, i);
+
+      g_string_append_printf (report, "\n%3u  %s = %s",
+                              watch->id, watch->expression,
+                              watch->value ? watch->value : "(not evaluated yet)");
+      if (watch->evaluations > 0)
+        g_string_append_printf (report, "\n     %u objects, %u runs, last %.2f ms, mean %.2f ms",
+                                gtk_inspector_handler_list_get_length (watch->handlers), watch->evaluations,
+                                watch->last_cost / 1000.0,
+                                watch->total_cost / 1000.0 / watch->evaluations);
+    }
+
+  return g_string_free (report, FALSE);
+}
+
+// vim: set et sw=2 ts=2:
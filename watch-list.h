@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _GTK_INSPECTOR_WATCH_LIST_H_
+#define _GTK_INSPECTOR_WATCH_LIST_H_
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+/* The columns of the list store the watches are shown in */
+enum {
+  GTK_INSPECTOR_WATCH_COLUMN_EXPRESSION,
+  GTK_INSPECTOR_WATCH_COLUMN_VALUE,
+  GTK_INSPECTOR_WATCH_COLUMN_COST
+};
+
+typedef struct _GtkInspectorWatchList GtkInspectorWatchList;
+
+/* Evaluates a watch, which must be answered with
+ * gtk_inspector_watch_list_set_result() */
+typedef void (* GtkInspectorWatchFunc) (GtkInspectorWatchList *list,
+                                        guint                  id,
+                                        const gchar           *expression,
+                                        gpointer               data);
+
+/* Watches are evaluated in a tick of the frame clock of widget, or at
+ * idle while it has none, and shown as rows of store */
+GtkInspectorWatchList *
+gtk_inspector_watch_list_new (GtkWidget             *widget,
+                              GtkListStore          *store,
+                              GtkInspectorWatchFunc  func,
+                              gpointer               data);
+
+void
+gtk_inspector_watch_list_free (GtkInspectorWatchList *list);
+
+/* Returns the id of the new watch, which is evaluated in the next frame */
+guint
+gtk_inspector_watch_list_add (GtkInspectorWatchList *list,
+                              const gchar           *expression);
+
+gboolean
+gtk_inspector_watch_list_remove (GtkInspectorWatchList *list,
+                                 guint                  id);
+
+void
+gtk_inspector_watch_list_clear (GtkInspectorWatchList *list);
+
+guint
+gtk_inspector_watch_list_get_n_watches (GtkInspectorWatchList *list);
+
+/* value describes the result of evaluating watch id, which took cost
+ * microseconds and reached objects. It is evaluated again once one of
+ * them notifies. */
+void
+gtk_inspector_watch_list_set_result (GtkInspectorWatchList *list,
+                                     guint                  id,
+                                     const gchar           *value,
+                                     gint64                 cost,
+                                     GPtrArray             *objects);
+
+gchar *
+gtk_inspector_watch_list_report (GtkInspectorWatchList *list);
+
+G_END_DECLS
+
+#endif // _GTK_INSPECTOR_WATCH_LIST_H_
+
+// vim: set et sw=2 ts=2:
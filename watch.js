@@ -0,0 +1,106 @@
+/* -*- mode: js2; js2-basic-offset: 4; indent-tabs-mode: nil -*- */
+
+const ValueView = imports.inspector.valueView;
+
+// A watch expression is evaluated against a view of the scope and the
+// global in which every object it reaches is a proxy.  The proxies
+// record the GObjects among them, which interactive.cpp listens to for
+// ::notify, so the watch is only evaluated again once one of them has
+// changed.  Methods are called on the real objects, with the real
+// objects as arguments, since gjs won't take a proxy for a GObject.
+
+function Tracker ()
+{
+    this.touched = [];
+    this.targets = new WeakMap();
+}
+
+Tracker.prototype = {
+    wrap: function(value) {
+        if (value === null || (typeof value !== 'object' && typeof value !== 'function'))
+            return value;
+
+        if (ValueView.isGObject(value) && this.touched.indexOf(value) < 0)
+            this.touched.push(value);
+
+        let proxy = new Proxy(value, this.handler());
+        this.targets.set(proxy, value);
+        return proxy;
+    },
+
+    unwrap: function(value) {
+        if (value !== null && (typeof value === 'object' || typeof value === 'function') &&
+            this.targets.has(value))
+            return this.targets.get(value);
+        return value;
+    },
+
+    handler: function() {
+        let tracker = this;
+        return {
+            get: function(target, name) {
+                let value = target[name];
+
+                // A proxy may not disguise a fixed property
+                let desc = Object.getOwnPropertyDescriptor(target, name);
+                if (desc && !desc.configurable && 'value' in desc && !desc.writable)
+                    return value;
+
+                return tracker.wrap(value);
+            },
+            apply: function(target, self, args) {
+                let real = [];
+                for (let i = 0; i < args.length; i++)
+                    real.push(tracker.unwrap(args[i]));
+                return tracker.wrap(target.apply(tracker.unwrap(self), real));
+            }
+        };
+    },
+
+    // Names resolve through the session scope first, then the global,
+    // the way they do at the prompt
+    scope: function(scope) {
+        let tracker = this;
+        return new Proxy(scope, {
+            has: function(target, name) {
+                // A proxied eval would be an indirect one, which
+                // can't see this scope
+                if (name === 'eval')
+                    return false;
+                return name in target || name in window;
+            },
+            get: function(target, name) {
+                if (!(name in target))
+                    return tracker.wrap(window[name]);
+
+                // The scope is frozen, see createScope
+                let desc = Object.getOwnPropertyDescriptor(target, name);
+                if (desc && !desc.configurable && 'value' in desc && !desc.writable)
+                    return target[name];
+
+                return tracker.wrap(target[name]);
+            }
+        });
+    }
+};
+
+// Called by interactive.cpp for each evaluation of a watch.  The
+// objects reached before an exception still count, since changing
+// them may make it go away.
+function evaluate (expression)
+{
+    let tracker = new Tracker();
+    let summary;
+
+    try {
+        let value;
+        with (tracker.scope(__session.scope))
+            value = eval (expression);
+        summary = ValueView.summarize(tracker.unwrap(value));
+    } catch (e) {
+        summary = "<exception " + String(e) + ">";
+    }
+
+    __watchResult(summary, tracker.touched);
+    return true;
+}
@@ -0,0 +1,438 @@
+/*
+ * Copyright (c) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <string.h>
+
+#include "widget-query.h"
+
+/* Selectors are matched right to left: candidates for the rightmost
+ * compound come from an index of the tree by type, and the compounds
+ * to the left are checked against their ancestors.
+ *
+ * The index of a root holds every widget below it in tree order and
+ * the positions of the widgets of each type. It is kept on the root
+ * and rebuilt when any widget has been added or removed anywhere,
+ * which a ::parent-set emission hook counts. Style classes and names
+ * are not indexed, so changes to those need no invalidation. */
+
+typedef enum {
+  COMBINATOR_DESCENDANT,
+  COMBINATOR_CHILD
+} Combinator;
+
+typedef struct
+{
+  GType       type;        /* 0 for any */
+  gboolean    never;       /* names a type that isn't registered */
+  GPtrArray  *classes;
+  gchar      *name;
+  Combinator  combinator;  /* relation to the compound on the left */
+} Compound;
+
+struct _GtkInspectorQuery
+{
+  GPtrArray *selectors;    /* GPtrArray of Compound, left to right */
+};
+
+typedef struct
+{
+  guint       generation;
+  GPtrArray  *widgets;     /* tree order, not referenced */
+  GHashTable *by_type;     /* GType -> GArray of positions in widgets */
+} WidgetIndex;
+
+static guint tree_generation;
+static GQuark index_quark;
+
+G_DEFINE_QUARK (gtk-inspector-query-error-quark, gtk_inspector_query_error)
+
+static void
+compound_free (gpointer data)
+{
+  Compound *compound = (Compound *)data;
+
+  g_ptr_array_unref (compound->classes);
+  g_free (compound->name);
+  g_free (compound);
+}
+
+static gboolean
+is_ident_char (gchar c)
+{
+  return g_ascii_isalnum (c) || c == '-' || c == '_';
+}
+
+static gchar *
+parse_ident (const gchar **p)
+{
+  const gchar *start = *p;
+
+  while (is_ident_char (**p))
+    (*p)++;
+
+  if (*p == start)
+    return NULL;
+
+  return g_strndup (start, *p - start);
+}
+
+static gboolean
+parse_compound (const gchar **p,
+                Compound     *compound,
+                GError      **error)
+{
+  gboolean empty = TRUE;
+
+  if (**p == '*')
+    {
+      (*p)++;
+      empty = FALSE;
+    }
+  else if (is_ident_char (**p))
+    {
+      gchar *type_name = parse_ident (p);
+
+      compound->type = g_type_from_name (type_name);
+      /* Types are registered when first used, so one that isn't
+       * registered can't have any instances */
+      compound->never = compound->type == 0;
+      g_free (type_name);
+      empty = FALSE;
+    }
+
+  while (**p == '.' || **p == '#')
+    {
+      gchar kind = **p;
+      gchar *ident;
+
+      (*p)++;
+      ident = parse_ident (p);
+      if (ident == NULL)
+        {
+          g_set_error (error, GTK_INSPECTOR_QUERY_ERROR, GTK_INSPECTOR_QUERY_ERROR_SYNTAX,
+                       "Expected a %s after '%c'", kind == '.' ? "style class" : "name", kind);
+          return FALSE;
+        }
+
+      if (kind == '.')
+        {
+          g_ptr_array_add (compound->classes, ident);
+        }
+      else
+        {
+          g_free (compound->name);
+          compound->name = ident;
+        }
+      empty = FALSE;
+    }
+
+  if (empty)
+    {
+      if (**p == '\0')
+        g_set_error (error, GTK_INSPECTOR_QUERY_ERROR, GTK_INSPECTOR_QUERY_ERROR_SYNTAX,
+                     "Unexpected end of selector");
+      else
+        g_set_error (error, GTK_INSPECTOR_QUERY_ERROR, GTK_INSPECTOR_QUERY_ERROR_SYNTAX,
+                     "Unexpected '%c'", **p);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+GtkInspectorQuery *
+gtk_inspector_query_new (const gchar  *selector,
+                         GError      **error)
+{
+  GtkInspectorQuery *query;
+  GPtrArray *compounds = NULL;
+  Combinator combinator = COMBINATOR_DESCENDANT;
+  const gchar *p = selector;
+
+  query = g_new0 (GtkInspectorQuery, 1);
+  query->selectors = g_ptr_array_new_with_free_func ((GDestroyNotify)g_ptr_array_unref);
+
+  while (TRUE)
+    {
+      Compound *compound;
+
+      while (g_ascii_isspace (*p))
+        p++;
+
+      if (compounds != NULL && *p == '>')
+        {
+          combinator = COMBINATOR_CHILD;
+          p++;
+          while (g_ascii_isspace (*p))
+            p++;
+        }
+
+      if (compounds == NULL)
+        {
+          compounds = g_ptr_array_new_with_free_func (compound_free);
+          g_ptr_array_add (query->selectors, compounds);
+        }
+
+      compound = g_new0 (Compound, 1);
+      compound->classes = g_ptr_array_new_with_free_func (g_free);
+      compound->combinator = combinator;
+      g_ptr_array_add (compounds, compound);
+
+      if (!parse_compound (&p, compound, error))
+        {
+          gtk_inspector_query_free (query);
+          return NULL;
+        }
+
+      if (*p != '\0' && *p != ',' && *p != '>' && !g_ascii_isspace (*p))
+        {
+          g_set_error (error, GTK_INSPECTOR_QUERY_ERROR, GTK_INSPECTOR_QUERY_ERROR_SYNTAX,
+                       "Unexpected '%c'", *p);
+          gtk_inspector_query_free (query);
+          return NULL;
+        }
+
+      combinator = COMBINATOR_DESCENDANT;
+      while (g_ascii_isspace (*p))
+        p++;
+
+      if (*p == '\0')
+        break;
+
+      if (*p == ',')
+        {
+          compounds = NULL;
+          p++;
+        }
+    }
+
+  return query;
+}
+
+void
+gtk_inspector_query_free (GtkInspectorQuery *query)
+{
+  g_ptr_array_unref (query->selectors);
+  g_free (query);
+}
+
+static gboolean
+parent_set_hook (GSignalInvocationHint *ihint,
+                 guint                  n_param_values,
+                 const GValue          *param_values,
+                 gpointer               data)
+{
+  tree_generation++;
+  return TRUE;
+}
+
+static void
+widget_index_free (gpointer data)
+{
+  WidgetIndex *index = (WidgetIndex *)data;
+
+  g_ptr_array_unref (index->widgets);
+  g_hash_table_unref (index->by_type);
+  g_free (index);
+}
+
+static void
+index_widget (GtkWidget *widget,
+              gpointer   data)
+{
+  WidgetIndex *index = (WidgetIndex *)data;
+  GType type = G_OBJECT_TYPE (widget);
+  GArray *positions;
+  guint position = index->widgets->len;
+
+  g_ptr_array_add (index->widgets, widget);
+
+  positions = (GArray *)g_hash_table_lookup (index->by_type, GSIZE_TO_POINTER (type));
+  if (positions == NULL)
+    {
+      positions = g_array_new (FALSE, FALSE, sizeof (guint));
+      g_hash_table_insert (index->by_type, GSIZE_TO_POINTER (type), positions);
+    }
+  g_array_append_val (positions, position);
+
+  /* forall rather than foreach, to include internal children */
+  if (GTK_IS_CONTAINER (widget))
+    gtk_container_forall (GTK_CONTAINER (widget), index_widget, index);
+}
+
+static WidgetIndex *
+get_index (GtkWidget *root)
+{
+  WidgetIndex *index;
+
+  if (index_quark == 0)
+    {
+      index_quark = g_quark_from_static_string ("gtk-inspector-widget-index");
+      g_signal_add_emission_hook (g_signal_lookup ("parent-set", GTK_TYPE_WIDGET), 0,
+                                  parent_set_hook, NULL, NULL);
+    }
+
+  index = (WidgetIndex *)g_object_get_qdata (G_OBJECT (root), index_quark);
+  if (index != NULL && index->generation == tree_generation)
+    return index;
+
+  index = g_new0 (WidgetIndex, 1);
+  index->generation = tree_generation;
+  index->widgets = g_ptr_array_new ();
+  index->by_type = g_hash_table_new_full (NULL, NULL, NULL, (GDestroyNotify)g_array_unref);
+  index_widget (root, index);
+
+  g_object_set_qdata_full (G_OBJECT (root), index_quark, index, widget_index_free);
+
+  return index;
+}
+
+static gboolean
+match_compound (const Compound *compound,
+                GtkWidget      *widget)
+{
+  guint i;
+
+  if (compound->never)
+    return FALSE;
+
+  if (compound->type != 0 && !g_type_is_a (G_OBJECT_TYPE (widget), compound->type))
+    return FALSE;
+
+  if (compound->name != NULL &&
+      g_strcmp0 (gtk_widget_get_name (widget), compound->name) != 0 &&
+      g_strcmp0 (gtk_buildable_get_name (GTK_BUILDABLE (widget)), compound->name) != 0)
+    return FALSE;
+
+  if (compound->classes->len > 0)
+    {
+      GtkStyleContext *context = gtk_widget_get_style_context (widget);
+
+      for (i = 0; i < compound->classes->len; i++)
+        if (!gtk_style_context_has_class (context, (const gchar *)compound->classes->pdata[i]))
+          return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* widget matched compound k; checks the ones left of it against the
+ * ancestors of widget, up to root */
+static gboolean
+match_ancestors (GPtrArray *compounds,
+                 guint      k,
+                 GtkWidget *widget,
+                 GtkWidget *root)
+{
+  const Compound *compound;
+  GtkWidget *ancestor;
+
+  if (k == 0)
+    return TRUE;
+
+  compound = (const Compound *)compounds->pdata[k];
+  if (widget == root)
+    return FALSE;
+
+  for (ancestor = gtk_widget_get_parent (widget); ancestor; ancestor = gtk_widget_get_parent (ancestor))
+    {
+      if (match_compound ((const Compound *)compounds->pdata[k - 1], ancestor) &&
+          match_ancestors (compounds, k - 1, ancestor, root))
+        return TRUE;
+
+      if (compound->combinator == COMBINATOR_CHILD || ancestor == root)
+        break;
+    }
+
+  return FALSE;
+}
+
+/* Marks the widgets matching one selector in matched */
+static void
+match_selector (GPtrArray   *compounds,
+                WidgetIndex *index,
+                GtkWidget   *root,
+                guint8      *matched)
+{
+  const Compound *last = (const Compound *)compounds->pdata[compounds->len - 1];
+  guint k = compounds->len - 1;
+  guint i;
+
+  if (last->never)
+    return;
+
+  if (last->type == 0)
+    {
+      for (i = 0; i < index->widgets->len; i++)
+        {
+          GtkWidget *widget = (GtkWidget *)index->widgets->pdata[i];
+
+          if (!matched[i] && match_compound (last, widget) &&
+              match_ancestors (compounds, k, widget, root))
+            matched[i] = TRUE;
+        }
+    }
+  else
+    {
+      GArray *candidates = g_array_new (FALSE, FALSE, sizeof (guint));
+      GHashTableIter iter;
+      gpointer key, value;
+
+      /* The few distinct types in the tree, rather than every widget */
+      g_hash_table_iter_init (&iter, index->by_type);
+      while (g_hash_table_iter_next (&iter, &key, &value))
+        if (g_type_is_a ((GType)GPOINTER_TO_SIZE (key), last->type))
+          g_array_append_vals (candidates, ((GArray *)value)->data, ((GArray *)value)->len);
+
+      for (i = 0; i < candidates->len; i++)
+        {
+          guint position = g_array_index (candidates, guint, i);
+          GtkWidget *widget = (GtkWidget *)index->widgets->pdata[position];
+
+          if (!matched[position] && match_compound (last, widget) &&
+              match_ancestors (compounds, k, widget, root))
+            matched[position] = TRUE;
+        }
+
+      g_array_unref (candidates);
+    }
+}
+
+void
+gtk_inspector_query_run (GtkInspectorQuery *query,
+                         GtkWidget         *root,
+                         GPtrArray         *results)
+{
+  WidgetIndex *index = get_index (root);
+  guint8 *matched;
+  guint i;
+
+  matched = g_new0 (guint8, index->widgets->len);
+
+  for (i = 0; i < query->selectors->len; i++)
+    match_selector ((GPtrArray *)query->selectors->pdata[i], index, root, matched);
+
+  for (i = 0; i < index->widgets->len; i++)
+    if (matched[i])
+      g_ptr_array_add (results, index->widgets->pdata[i]);
+
+  g_free (matched);
+}
+
+// vim: set et sw=2 ts=2:
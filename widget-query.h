@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2014 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef _GTK_INSPECTOR_WIDGET_QUERY_H_
+#define _GTK_INSPECTOR_WIDGET_QUERY_H_
+
+#include <gtk/gtk.h>
+
+G_BEGIN_DECLS
+
+#define GTK_INSPECTOR_QUERY_ERROR (gtk_inspector_query_error_quark ())
+
+typedef enum {
+  GTK_INSPECTOR_QUERY_ERROR_SYNTAX
+} GtkInspectorQueryError;
+
+GQuark
+gtk_inspector_query_error_quark (void);
+
+/* A compiled selector such as "GtkButton.suggested-action > GtkLabel".
+ * Supported are type names (matching subtypes too) or *, .style-class,
+ * #name (widget name or buildable id), the descendant and > child
+ * combinators, and comma separated lists. */
+typedef struct _GtkInspectorQuery GtkInspectorQuery;
+
+GtkInspectorQuery *
+gtk_inspector_query_new (const gchar  *selector,
+                         GError      **error);
+
+void
+gtk_inspector_query_free (GtkInspectorQuery *query);
+
+/* Appends the widgets that match, out of root and everything below
+ * it, in tree order */
+void
+gtk_inspector_query_run (GtkInspectorQuery *query,
+                         GtkWidget         *root,
+                         GPtrArray         *results);
+
+G_END_DECLS
+
+#endif // _GTK_INSPECTOR_WIDGET_QUERY_H_
+
+// vim: set et sw=2 ts=2: